@@ -0,0 +1,5 @@
+for /F "tokens=*" %%I in (Config.ini) do set %%I
+
+rem Two standalone peers on this machine with 60ms of artificial one-way latency
+start "" %engine% %project% %map% -game -windowed -resx=960 -resy=540 -log -rollback -rollbackplayer=0 -rollbackport=7000 -rollbackpeer=127.0.0.1:7001 -rollbacklatency=60 -rollbackjitter=10
+start "" %engine% %project% %map% -game -windowed -resx=960 -resy=540 -log -rollback -rollbackplayer=1 -rollbackport=7001 -rollbackpeer=127.0.0.1:7000 -rollbacklatency=60 -rollbackjitter=10
@@ -0,0 +1,5 @@
+for /F "tokens=*" %%I in (Config.ini) do set %%I
+
+rem Plays the default map headless with a few bots, then writes Saved/LoadOrder and exits.
+rem Copy GameOpenOrder.log to Build/LinuxNoEditor/FileOpenOrder and BootPackages.txt to Build/LoadOrder before packaging.
+%engine% %project% %map% -game -nullrhi -nosound -unattended -log -bots=4 -RecordLoadOrder=20
@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AimSolverManager.h"
+#include "WTFProject.h"
+#include "AI/StoneBotController.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(AimSolver, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("Aim Solver Batch"), STAT_AimSolverBatch, STATGROUP_WTFProject);
+DECLARE_CYCLE_STAT(TEXT("Aim Solver Line Of Sight"), STAT_AimSolverTraces, STATGROUP_WTFProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Aim Solver Requests"), STAT_AimSolverRequests, STATGROUP_WTFProject);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdAimSolverBenchmark(
+	TEXT("wtf.AimSolver.Benchmark"),
+	TEXT("wtf.AimSolver.Benchmark [Bots=100] [Frames=300]: measures the per-frame cost of solving one aim request per bot."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 Bots = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100;
+		const int32 Frames = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 300;
+		AAimSolverManager::RunBenchmark(World, Bots, Frames);
+	}));
+
+AAimSolverManager::AAimSolverManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// Bots ask during pre-physics, targets have moved by now
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+	bReplicates = false;
+}
+
+AAimSolverManager* AAimSolverManager::Get(UWorld* World)
+{
+	for (TActorIterator<AAimSolverManager> It(World); It; ++It)
+		return *It;
+
+	FActorSpawnParameters Params;
+	Params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return World->SpawnActor<AAimSolverManager>(AAimSolverManager::StaticClass(), FTransform::Identity, Params);
+}
+
+void AAimSolverManager::RequestAim(AStoneBotController* Bot, const FBallisticAimRequest& Request)
+{
+	Batch.Add(Request);
+	Bots.Add(Bot);
+}
+
+void AAimSolverManager::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	SET_DWORD_STAT(STAT_AimSolverRequests, Batch.Num());
+	if (Batch.Num() == 0)
+		return;
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_AimSolverBatch);
+		Batch.Solve();
+	}
+	{
+		SCOPE_CYCLE_COUNTER(STAT_AimSolverTraces);
+		Batch.ChooseArcs(GetWorld());
+	}
+
+	for (int32 i = 0; i < Bots.Num(); i++)
+	{
+		if (AStoneBotController* Bot = Bots[i].Get())
+			Bot->OnAimSolved(Batch.GetResult(i));
+	}
+
+	Batch.Reset();
+	Bots.Reset();
+}
+
+void AAimSolverManager::RunBenchmark(UWorld* World, int32 NumBots, int32 Frames)
+{
+	if (!World || NumBots <= 0 || Frames <= 0)
+		return;
+
+	FVector Center = FVector::ZeroVector;
+	APlayerController* PlController = World->GetFirstPlayerController();
+	if (PlController && PlController->GetPawn())
+		Center = PlController->GetPawn()->GetActorLocation();
+
+	FBallisticAimBatch BenchBatch;
+	double SolveMs = 0.0;
+	double TraceMs = 0.0;
+	double MaxMs = 0.0;
+	int32 NumValid = 0;
+	for (int32 Frame = 0; Frame < Frames; Frame++)
+	{
+		BenchBatch.Reset();
+		for (int32 i = 0; i < NumBots; i++)
+		{
+			FBallisticAimRequest Request;
+			Request.Origin = Center + FVector(FMath::FRandRange(-2000.f, 2000.f), 0.f, FMath::FRandRange(0.f, 300.f));
+			Request.Target = Center + FVector(FMath::FRandRange(-2000.f, 2000.f), 0.f, FMath::FRandRange(0.f, 300.f));
+			Request.TargetVelocity = FVector(FMath::FRandRange(-600.f, 600.f), 0.f, FMath::FRandRange(-500.f, 1000.f));
+			Request.Speed = 1500.f;
+			Request.GravityZ = World->GetGravityZ();
+			BenchBatch.Add(Request);
+		}
+
+		const double Start = FPlatformTime::Seconds();
+		BenchBatch.Solve();
+		const double Solved = FPlatformTime::Seconds();
+		BenchBatch.ChooseArcs(World);
+		const double End = FPlatformTime::Seconds();
+
+		SolveMs += (Solved - Start) * 1000.0;
+		TraceMs += (End - Solved) * 1000.0;
+		MaxMs = FMath::Max(MaxMs, (End - Start) * 1000.0);
+		for (int32 i = 0; i < NumBots; i++)
+			NumValid += BenchBatch.GetResult(i).bValid ? 1 : 0;
+	}
+
+	UE_LOG(AimSolver, Display, TEXT("Aim solver benchmark: %d bots, %d frames, solve avg %.4fms, line of sight avg %.4fms, frame max %.4fms, %.0f%% with a clear arc"),
+		NumBots, Frames, SolveMs / Frames, TraceMs / Frames, MaxMs, 100.0 * NumValid / (NumBots * Frames));
+}
@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "AI/BallisticAimSolver.h"
+#include "AimSolverManager.generated.h"
+
+class AStoneBotController;
+
+/**
+ * Collects the aim requests of every bot during the pre-physics tick and answers all of them in one
+ * FBallisticAimBatch after physics, so the solver cost is paid once per frame however many bots ask.
+ */
+UCLASS()
+class WTFPROJECT_API AAimSolverManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AAimSolverManager();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Spawns the manager on first use */
+	static AAimSolverManager* Get(UWorld* World);
+
+	/** Answered through AStoneBotController::OnAimSolved later this frame */
+	void RequestAim(AStoneBotController* Bot, const FBallisticAimRequest& Request);
+
+	/** Solves Bots random requests around the first player Frames times and logs the cost of both passes */
+	static void RunBenchmark(UWorld* World, int32 Bots, int32 Frames);
+
+private:
+	FBallisticAimBatch Batch;
+	TArray<TWeakObjectPtr<AStoneBotController>> Bots;
+};
@@ -0,0 +1,195 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BallisticAimSolver.h"
+#include "Engine/World.h"
+#include "Math/VectorRegister.h"
+
+namespace
+{
+	/** Below this gravity stones fly straight and both arcs are the direct line */
+	const float MinGravity = 1.f;
+
+	FORCEINLINE VectorRegister VectorSqrtSafe(const VectorRegister& Value)
+	{
+		const VectorRegister Clamped = VectorMax(Value, VectorSetFloat1(SMALL_NUMBER));
+		return VectorMultiply(Clamped, VectorReciprocalSqrtAccurate(Clamped));
+	}
+}
+
+void FBallisticAimBatch::Reset()
+{
+	Requests.Reset();
+	Results.Reset();
+	NumLanes = 0;
+}
+
+int32 FBallisticAimBatch::Add(const FBallisticAimRequest& Request)
+{
+	Results.AddDefaulted();
+	return Requests.Add(Request);
+}
+
+void FBallisticAimBatch::Solve()
+{
+	// Lanes are padded to a multiple of four with a harmless request
+	NumLanes = Align(Requests.Num(), 4);
+	for (FLaneArray* Lane : { &TargetX, &TargetZ, &TargetVX, &TargetVZ, &OriginX, &OriginZ, &Speed, &Gravity, &DX, &DZ,
+		&LowX, &LowZ, &LowTime, &LowValid, &HighX, &HighZ, &HighTime, &HighValid })
+	{
+		Lane->SetNumUninitialized(NumLanes, false);
+	}
+
+	for (int32 i = 0; i < NumLanes; i++)
+	{
+		const bool bPadding = i >= Requests.Num();
+		const FBallisticAimRequest& Request = Requests[bPadding ? 0 : i];
+		TargetX[i] = bPadding ? 1.f : Request.Target.X;
+		TargetZ[i] = bPadding ? 0.f : Request.Target.Z;
+		TargetVX[i] = bPadding ? 0.f : Request.TargetVelocity.X;
+		TargetVZ[i] = bPadding ? 0.f : Request.TargetVelocity.Z;
+		OriginX[i] = bPadding ? 0.f : Request.Origin.X;
+		OriginZ[i] = bPadding ? 0.f : Request.Origin.Z;
+		Speed[i] = bPadding ? 1.f : FMath::Max(Request.Speed, 1.f);
+		Gravity[i] = bPadding ? 0.f : FMath::Max(-Request.GravityZ, 0.f);
+		DX[i] = TargetX[i] - OriginX[i];
+		DZ[i] = TargetZ[i] - OriginZ[i];
+	}
+
+	SolveLanes(DX, DZ, true, true);
+
+	// Lead the target by the flight time of each arc, the arcs take very different times
+	for (int32 Pass = 0; Pass < PredictionPasses; Pass++)
+	{
+		for (int32 Arc = 0; Arc < 2; Arc++)
+		{
+			const float* Time = Arc == 0 ? LowTime.GetData() : HighTime.GetData();
+			for (int32 i = 0; i < NumLanes; i += 4)
+			{
+				const VectorRegister T = VectorLoadAligned(Time + i);
+				VectorStoreAligned(VectorSubtract(VectorMultiplyAdd(VectorLoadAligned(TargetVX.GetData() + i), T, VectorLoadAligned(TargetX.GetData() + i)), VectorLoadAligned(OriginX.GetData() + i)), DX.GetData() + i);
+				VectorStoreAligned(VectorSubtract(VectorMultiplyAdd(VectorLoadAligned(TargetVZ.GetData() + i), T, VectorLoadAligned(TargetZ.GetData() + i)), VectorLoadAligned(OriginZ.GetData() + i)), DZ.GetData() + i);
+			}
+			SolveLanes(DX, DZ, Arc == 0, Arc == 1);
+		}
+	}
+}
+
+void FBallisticAimBatch::SolveLanes(const FLaneArray& InDX, const FLaneArray& InDZ, bool bKeepLow, bool bKeepHigh)
+{
+	const VectorRegister Zero = VectorZero();
+	const VectorRegister One = VectorOne();
+	const VectorRegister Two = VectorSetFloat1(2.f);
+	const VectorRegister Tiny = VectorSetFloat1(SMALL_NUMBER);
+	const VectorRegister Cos45 = VectorSetFloat1(0.70710678f);
+	const VectorRegister GravityThreshold = VectorSetFloat1(MinGravity);
+
+	for (int32 i = 0; i < NumLanes; i += 4)
+	{
+		const VectorRegister X = VectorLoadAligned(InDX.GetData() + i);
+		const VectorRegister Z = VectorLoadAligned(InDZ.GetData() + i);
+		const VectorRegister V = VectorLoadAligned(Speed.GetData() + i);
+		const VectorRegister G = VectorLoadAligned(Gravity.GetData() + i);
+
+		// tan(angle) = (v^2 -+ sqrt(v^4 - g (g x^2 + 2 z v^2))) / (g x)
+		const VectorRegister AbsX = VectorMax(VectorAbs(X), One);
+		const VectorRegister V2 = VectorMultiply(V, V);
+		const VectorRegister Inner = VectorMultiplyAdd(VectorMultiply(G, AbsX), AbsX, VectorMultiply(Two, VectorMultiply(Z, V2)));
+		const VectorRegister Disc = VectorSubtract(VectorMultiply(V2, V2), VectorMultiply(G, Inner));
+		const VectorRegister bFlat = VectorCompareLT(G, GravityThreshold);
+		const VectorRegister bInRange = VectorBitwiseOr(VectorCompareGE(Disc, Zero), bFlat);
+
+		const VectorRegister SqrtDisc = VectorSqrtSafe(Disc);
+		const VectorRegister InvGX = VectorReciprocalAccurate(VectorMax(VectorMultiply(G, AbsX), Tiny));
+		const VectorRegister TanLow = VectorMultiply(VectorSubtract(V2, SqrtDisc), InvGX);
+		const VectorRegister TanHigh = VectorMultiply(VectorAdd(V2, SqrtDisc), InvGX);
+
+		// Out of range aims at the longest throw, 45 degrees
+		VectorRegister CosLow = VectorSelect(bInRange, VectorReciprocalSqrtAccurate(VectorMultiplyAdd(TanLow, TanLow, One)), Cos45);
+		VectorRegister SinLow = VectorSelect(bInRange, VectorMultiply(TanLow, CosLow), Cos45);
+		VectorRegister CosHigh = VectorSelect(bInRange, VectorReciprocalSqrtAccurate(VectorMultiplyAdd(TanHigh, TanHigh, One)), Cos45);
+		VectorRegister SinHigh = VectorSelect(bInRange, VectorMultiply(TanHigh, CosHigh), Cos45);
+		VectorRegister TimeLow = VectorMultiply(AbsX, VectorReciprocalAccurate(VectorMax(VectorMultiply(V, CosLow), Tiny)));
+		VectorRegister TimeHigh = VectorMultiply(AbsX, VectorReciprocalAccurate(VectorMax(VectorMultiply(V, CosHigh), Tiny)));
+
+		// No gravity: both arcs are the straight line
+		const VectorRegister Dist2 = VectorMultiplyAdd(X, X, VectorMultiply(Z, Z));
+		const VectorRegister InvDist = VectorReciprocalSqrtAccurate(VectorMax(Dist2, Tiny));
+		const VectorRegister StraightCos = VectorMultiply(VectorAbs(X), InvDist);
+		const VectorRegister StraightSin = VectorMultiply(Z, InvDist);
+		const VectorRegister StraightTime = VectorMultiply(VectorSqrtSafe(Dist2), VectorReciprocalAccurate(V));
+		CosLow = VectorSelect(bFlat, StraightCos, CosLow);
+		SinLow = VectorSelect(bFlat, StraightSin, SinLow);
+		TimeLow = VectorSelect(bFlat, StraightTime, TimeLow);
+		CosHigh = VectorSelect(bFlat, StraightCos, CosHigh);
+		SinHigh = VectorSelect(bFlat, StraightSin, SinHigh);
+		TimeHigh = VectorSelect(bFlat, StraightTime, TimeHigh);
+
+		// Solved for |x|, mirror towards the target
+		const VectorRegister bLeft = VectorCompareLT(X, Zero);
+		const VectorRegister ValidValue = VectorSelect(bInRange, One, Zero);
+		if (bKeepLow)
+		{
+			VectorStoreAligned(VectorSelect(bLeft, VectorNegate(CosLow), CosLow), LowX.GetData() + i);
+			VectorStoreAligned(SinLow, LowZ.GetData() + i);
+			VectorStoreAligned(TimeLow, LowTime.GetData() + i);
+			VectorStoreAligned(ValidValue, LowValid.GetData() + i);
+		}
+		if (bKeepHigh)
+		{
+			VectorStoreAligned(VectorSelect(bLeft, VectorNegate(CosHigh), CosHigh), HighX.GetData() + i);
+			VectorStoreAligned(SinHigh, HighZ.GetData() + i);
+			VectorStoreAligned(TimeHigh, HighTime.GetData() + i);
+			VectorStoreAligned(ValidValue, HighValid.GetData() + i);
+		}
+	}
+}
+
+bool FBallisticAimBatch::IsArcClear(UWorld* World, const FBallisticAimRequest& Request, const FVector& Direction, float FlightTime) const
+{
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(BotAimTrace), false);
+	Params.AddIgnoredActor(Request.Thrower);
+	Params.AddIgnoredActor(Request.TargetActor);
+
+	const FVector Velocity = Direction * Request.Speed;
+	FVector Start = Request.Origin;
+	for (int32 Segment = 1; Segment <= TraceSegments; Segment++)
+	{
+		const float Time = FlightTime * Segment / TraceSegments;
+		const FVector End = Request.Origin + Velocity * Time + FVector(0.f, 0.f, 0.5f * Request.GravityZ * Time * Time);
+		if (World->LineTraceTestByChannel(Start, End, ECC_Visibility, Params))
+			return false;
+		Start = End;
+	}
+	return true;
+}
+
+void FBallisticAimBatch::ChooseArcs(UWorld* World)
+{
+	for (int32 i = 0; i < Requests.Num(); i++)
+	{
+		const FBallisticAimRequest& Request = Requests[i];
+		FBallisticAimResult& Result = Results[i];
+
+		const FVector Low(LowX[i], 0.f, LowZ[i]);
+		Result.Direction = Low;
+		Result.FlightTime = LowTime[i];
+		Result.bHighArc = false;
+		Result.bValid = false;
+
+		if (LowValid[i] != 0.f && (!World || IsArcClear(World, Request, Low, LowTime[i])))
+		{
+			Result.bValid = true;
+		}
+		else if (HighValid[i] != 0.f && Gravity[i] >= MinGravity)
+		{
+			const FVector High(HighX[i], 0.f, HighZ[i]);
+			if (!World || IsArcClear(World, Request, High, HighTime[i]))
+			{
+				Result.Direction = High;
+				Result.FlightTime = HighTime[i];
+				Result.bHighArc = true;
+				Result.bValid = true;
+			}
+		}
+	}
+}
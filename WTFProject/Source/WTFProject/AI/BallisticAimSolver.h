@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class UWorld;
+
+struct FBallisticAimRequest
+{
+	FVector Origin = FVector::ZeroVector;
+	FVector Target = FVector::ZeroVector;
+	FVector TargetVelocity = FVector::ZeroVector;
+	float Speed = 1000.f;
+	/** World gravity times the projectile gravity scale, negative is down */
+	float GravityZ = 0.f;
+
+	/** Ignored by the line of sight traces */
+	const AActor* Thrower = nullptr;
+	const AActor* TargetActor = nullptr;
+};
+
+struct FBallisticAimResult
+{
+	FVector Direction = FVector::ForwardVector;
+	float FlightTime = 0.f;
+	/** The target is in range and one of the arcs has a clear path */
+	bool bValid = false;
+	bool bHighArc = false;
+};
+
+/**
+ * Inverse ballistics for a whole frame of aim requests. Requests are gathered in structure-of-arrays form,
+ * both arcs of every request are solved four lanes at a time with VectorRegister math, then the predicted
+ * target position is refined with the flight time of each arc. Arc choice needs the world, so it is a
+ * separate pass of line traces along the low arc first and the high arc if the low one is blocked.
+ *
+ * Everything happens in the XZ plane the game is played in, Y of the inputs is ignored.
+ */
+class WTFPROJECT_API FBallisticAimBatch
+{
+public:
+	/** Lead refinement passes on top of the initial solve against the current target position */
+	static const int32 PredictionPasses = 2;
+
+	/** Segments per arc for the line of sight check */
+	static const int32 TraceSegments = 4;
+
+	void Reset();
+	int32 Add(const FBallisticAimRequest& Request);
+	int32 Num() const { return Requests.Num(); }
+
+	/** Solves low and high arcs for every request, no world access */
+	void Solve();
+
+	/** Picks the arc with line of sight for every request and fills the results */
+	void ChooseArcs(UWorld* World);
+
+	const FBallisticAimResult& GetResult(int32 Index) const { return Results[Index]; }
+
+private:
+	typedef TArray<float, TAlignedHeapAllocator<16>> FLaneArray;
+
+	/** Both arcs for DX, DZ per lane, the valid lanes hold 1 where the target is in range of that arc */
+	void SolveLanes(const FLaneArray& InDX, const FLaneArray& InDZ, bool bKeepLow, bool bKeepHigh);
+	bool IsArcClear(UWorld* World, const FBallisticAimRequest& Request, const FVector& Direction, float FlightTime) const;
+
+	TArray<FBallisticAimRequest> Requests;
+	TArray<FBallisticAimResult> Results;
+
+	int32 NumLanes = 0;
+	FLaneArray TargetX, TargetZ, TargetVX, TargetVZ, OriginX, OriginZ, Speed, Gravity;
+	FLaneArray DX, DZ;
+	FLaneArray LowX, LowZ, LowTime, LowValid, HighX, HighZ, HighTime, HighValid;
+};
@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "StoneBotController.h"
+#include "AI/AimSolverManager.h"
+#include "WTFProjectCharacter.h"
+#include "Objects/Stone.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+
+DEFINE_LOG_CATEGORY_STATIC(StoneBot, Log, All);
+
+AStoneBotController::AStoneBotController()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+	// Facing comes from the character's rules through SetControlRotation, don't copy it back from the pawn
+	bSetControlRotationFromPawnOrientation = false;
+}
+
+AActor* AStoneBotController::FindTarget() const
+{
+	APawn* Self = GetPawn();
+	AActor* Closest = nullptr;
+	float ClosestDistSq = FMath::Square(MaxThrowRange);
+	for (TActorIterator<AWTFProjectCharacter> It(GetWorld()); It; ++It)
+	{
+		if (*It == Self)
+			continue;
+
+		const float DistSq = FVector::DistSquared(It->GetActorLocation(), Self->GetActorLocation());
+		if (DistSq < ClosestDistSq)
+		{
+			ClosestDistSq = DistSq;
+			Closest = *It;
+		}
+	}
+	return Closest;
+}
+
+bool AStoneBotController::MakeAimRequest(AWTFProjectCharacter* Character, AActor* TargetActor, FBallisticAimRequest& OutRequest)
+{
+	if (!Character->StoneClass)
+		return false;
+
+	// Same numbers a thrown stone starts with
+	const AStone* DefaultStone = Character->StoneClass->GetDefaultObject<AStone>();
+	OutRequest.Origin = Character->GetActorLocation() + Character->StoneSpawnLocation;
+	OutRequest.Target = TargetActor->GetActorLocation();
+	OutRequest.TargetVelocity = TargetActor->GetVelocity();
+	OutRequest.Speed = DefaultStone->GetLaunchSpeed();
+	OutRequest.GravityZ = Character->GetWorld()->GetGravityZ() * DefaultStone->GetLaunchGravityScale();
+	OutRequest.Thrower = Character;
+	OutRequest.TargetActor = TargetActor;
+	return true;
+}
+
+void AStoneBotController::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	AWTFProjectCharacter* Character = Cast<AWTFProjectCharacter>(GetPawn());
+	if (!Character)
+		return;
+
+	if (Character->IsAiming())
+		AimTime += DeltaSeconds;
+	else
+		Cooldown -= DeltaSeconds;
+
+	if (!Character->IsAiming() && (Cooldown > 0.f || !Character->CanAim()))
+		return;
+
+	AActor* NewTarget = FindTarget();
+	Target = NewTarget;
+	if (!NewTarget)
+	{
+		if (Character->IsAiming())
+			Character->StopAim();
+		return;
+	}
+
+	FBallisticAimRequest Request;
+	if (MakeAimRequest(Character, NewTarget, Request))
+		AAimSolverManager::Get(GetWorld())->RequestAim(this, Request);
+}
+
+void AStoneBotController::OnAimSolved(const FBallisticAimResult& Result)
+{
+	AWTFProjectCharacter* Character = Cast<AWTFProjectCharacter>(GetPawn());
+	if (!Character)
+		return;
+
+	if (!Result.bValid)
+	{
+		// Blocked both ways, wait for the target to move instead of throwing into the wall
+		if (Character->IsAiming())
+			Character->StopAim();
+		return;
+	}
+
+	Character->CoreState.AimDirection = WTFCore::FVec2(Result.Direction.X, Result.Direction.Z);
+	if (!Character->IsAiming())
+	{
+		Character->Aim();
+		AimTime = 0.f;
+	}
+	else if (AimTime >= AimHoldTime)
+	{
+		Character->Throw();
+		Cooldown = ThrowInterval;
+		UE_LOG(StoneBot, Verbose, TEXT("%s throws at %s, %s arc, %.2fs flight"), *GetName(), Target.IsValid() ? *Target->GetName() : TEXT("none"),
+			Result.bHighArc ? TEXT("high") : TEXT("low"), Result.FlightTime);
+	}
+}
+
+void AStoneBotController::SpawnBots(UWorld* World, UClass* PawnClass, const FVector& Location, int32 Count)
+{
+	if (!World || !PawnClass)
+		return;
+
+	FActorSpawnParameters Params;
+	Params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	for (int32 i = 0; i < Count; i++)
+	{
+		const FVector SpawnLocation = Location + FVector((i + 1) * 200.f * ((i & 1) ? -1.f : 1.f), 0.f, 0.f);
+		APawn* Pawn = World->SpawnActor<APawn>(PawnClass, SpawnLocation, FRotator::ZeroRotator, Params);
+		if (!Pawn)
+			continue;
+
+		AStoneBotController* Bot = World->SpawnActor<AStoneBotController>(AStoneBotController::StaticClass(), SpawnLocation, FRotator::ZeroRotator, Params);
+		Bot->Possess(Pawn);
+	}
+	UE_LOG(StoneBot, Display, TEXT("Spawned %d bots"), Count);
+}
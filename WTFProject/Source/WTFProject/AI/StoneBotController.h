@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "AI/BallisticAimSolver.h"
+#include "StoneBotController.generated.h"
+
+class AWTFProjectCharacter;
+
+/**
+ * Stone throwing opponent. Every frame it is in range it asks AAimSolverManager for a launch direction
+ * at the predicted position of the closest other character, and drives its character through the same
+ * Aim / Throw handlers the input bindings use, with the solved direction as AimDirection.
+ */
+UCLASS()
+class WTFPROJECT_API AStoneBotController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+	AStoneBotController();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Result of this frame's request */
+	void OnAimSolved(const FBallisticAimResult& Result);
+
+	/** Fills the request for Character throwing its stone class at Target, false if it has no stone class */
+	static bool MakeAimRequest(AWTFProjectCharacter* Character, AActor* Target, FBallisticAimRequest& OutRequest);
+
+	/** Spawns Count bot characters of PawnClass spread around Location */
+	static void SpawnBots(UWorld* World, UClass* PawnClass, const FVector& Location, int32 Count);
+
+protected:
+	/** Seconds between the end of a throw and the next aim */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	float ThrowInterval = 1.5f;
+
+	/** Seconds the bot aims before releasing, so the aim animation is visible */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	float AimHoldTime = 0.3f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	float MaxThrowRange = 3000.f;
+
+private:
+	AActor* FindTarget() const;
+
+	TWeakObjectPtr<AActor> Target;
+	float Cooldown = 0.f;
+	float AimTime = 0.f;
+};
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AssetManagerWTF.h"
+#include "Debug/LoadOrderRecorder.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(AssetManagerWTF, Log, All);
+
+#if WITH_EDITOR
+void UAssetManagerWTF::LoadBootPackages() const
+{
+	bBootPackagesLoaded = true;
+
+	const FString FileName = FPaths::ProjectDir() / TEXT("Build/LoadOrder") / FLoadOrderRecorder::BootPackagesFileName;
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *FileName))
+	{
+		UE_LOG(AssetManagerWTF, Display, TEXT("No %s, game content is not split into boot and rare chunks"), *FileName);
+		return;
+	}
+
+	for (const FString& Line : Lines)
+	{
+		const FString PackageName = Line.TrimStartAndEnd();
+		if (!PackageName.IsEmpty())
+			BootPackages.Add(FName(*PackageName));
+	}
+	UE_LOG(AssetManagerWTF, Display, TEXT("%d boot packages go to chunk %d, other game content to chunk %d"), BootPackages.Num(), BootChunkId, RareChunkId);
+}
+
+bool UAssetManagerWTF::GetPackageChunkIds(FName PackageName, const ITargetPlatform* TargetPlatform, const TArray<int32>& ExistingChunkList, TArray<int32>& OutChunkList) const
+{
+	if (!bBootPackagesLoaded)
+		LoadBootPackages();
+
+	// Engine and plugin content keeps the default assignment
+	if (BootPackages.Num() == 0 || !PackageName.ToString().StartsWith(TEXT("/Game/")))
+		return Super::GetPackageChunkIds(PackageName, TargetPlatform, ExistingChunkList, OutChunkList);
+
+	OutChunkList.Reset();
+	OutChunkList.Add(BootPackages.Contains(PackageName) ? BootChunkId : RareChunkId);
+	return true;
+}
+#endif
@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/AssetManager.h"
+#include "AssetManagerWTF.generated.h"
+
+/**
+ * Splits cooked game content into two paks: everything FLoadOrderRecorder saw during a recorded run of
+ * the default map goes to BootChunkId, the rest to RareChunkId. The boot list is read from
+ * Build/LoadOrder/BootPackages.txt; without it chunking falls back to the engine's rules.
+ */
+UCLASS()
+class WTFPROJECT_API UAssetManagerWTF : public UAssetManager
+{
+	GENERATED_BODY()
+
+public:
+	static const int32 BootChunkId = 0;
+	static const int32 RareChunkId = 1;
+
+#if WITH_EDITOR
+	virtual bool GetPackageChunkIds(FName PackageName, const class ITargetPlatform* TargetPlatform, const TArray<int32>& ExistingChunkList, TArray<int32>& OutChunkList) const override;
+
+private:
+	void LoadBootPackages() const;
+
+	mutable TSet<FName> BootPackages;
+	mutable bool bBootPackagesLoaded = false;
+#endif
+};
@@ -0,0 +1,170 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SplitscreenCamera.h"
+#include "WTFProject.h"
+#include "WTFProjectCharacter.h"
+#include "Camera/CameraComponent.h"
+#include "Engine/World.h"
+#include "Engine/GameInstance.h"
+#include "Engine/GameViewportClient.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(SplitscreenCamera, Log, All);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Splitscreen Scene Views"), STAT_SplitscreenViews, STATGROUP_WTFProject);
+
+static TAutoConsoleVariable<int32> CVarSharedCamera(
+	TEXT("wtf.SharedCamera"),
+	1,
+	TEXT("1 merges local players into one view while they fit on screen, 0 always splits the viewport."));
+
+ASplitscreenCamera::ASplitscreenCamera()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// After the characters moved, before the player camera managers read the view
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+	bReplicates = false;
+
+	Camera = CreateDefaultSubobject<UCameraComponent>(TEXT("Camera"));
+	Camera->ProjectionMode = ECameraProjectionMode::Orthographic;
+	Camera->OrthoWidth = 2048.f;
+	Camera->bConstrainAspectRatio = false;
+	RootComponent = Camera;
+}
+
+void ASplitscreenCamera::EnsureForWorld(UWorld* World)
+{
+	if (!World || !World->IsGameWorld() || World->GetNetMode() == NM_DedicatedServer)
+		return;
+
+	UGameInstance* GameInstance = World->GetGameInstance();
+	if (!GameInstance || GameInstance->GetNumLocalPlayers() < 2)
+		return;
+
+	if (TActorIterator<ASplitscreenCamera>(World))
+		return;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	World->SpawnActor<ASplitscreenCamera>(ASplitscreenCamera::StaticClass(), FTransform::Identity, SpawnParams);
+}
+
+void ASplitscreenCamera::GatherLocalViews(TArray<FLocalView>& OutViews) const
+{
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PlController = It->Get();
+		if (!PlController || !PlController->IsLocalController())
+			continue;
+
+		AWTFProjectCharacter* Character = Cast<AWTFProjectCharacter>(PlController->GetPawn());
+		if (Character && Character->GetSideViewCameraComponent())
+			OutViews.Add({ PlController, Character });
+	}
+}
+
+void ASplitscreenCamera::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	TArray<FLocalView> Views;
+	GatherLocalViews(Views);
+	UGameViewportClient* Viewport = GetWorld()->GetGameViewport();
+	if (!Viewport || Views.Num() < 2)
+	{
+		if (bMerged)
+			SetMerged(false, Views);
+		SET_DWORD_STAT(STAT_SplitscreenViews, Views.Num());
+		return;
+	}
+
+	FBox2D Bounds(ForceInit);
+	for (const FLocalView& View : Views)
+	{
+		const FVector Location = View.Character->GetActorLocation();
+		Bounds += FVector2D(Location.X, Location.Z);
+	}
+
+	FVector2D ViewportSize(16.f, 9.f);
+	Viewport->GetViewportSize(ViewportSize);
+	const float AspectRatio = ViewportSize.Y > 0.f ? ViewportSize.X / ViewportSize.Y : 16.f / 9.f;
+
+	// The shared view never shows less than one character camera would
+	UCameraComponent* ReferenceCamera = Views[0].Character->GetSideViewCameraComponent();
+	const FVector2D Size = Bounds.GetSize() + FVector2D(ScreenMargin, ScreenMargin) * 2.f;
+	const float RequiredWidth = FMath::Max3(ReferenceCamera->OrthoWidth, Size.X, Size.Y * AspectRatio);
+
+	const float Now = GetWorld()->GetRealTimeSeconds();
+	if (Now - LastSwitchTime >= MinSwitchInterval)
+	{
+		const bool bAllowMerge = CVarSharedCamera.GetValueOnGameThread() != 0;
+		if (bMerged && (!bAllowMerge || RequiredWidth > MaxOrthoWidth))
+			SetMerged(false, Views);
+		else if (!bMerged && bAllowMerge && RequiredWidth < MaxOrthoWidth * MergeThreshold)
+			SetMerged(true, Views);
+	}
+
+	// A respawned pawn takes the view back on possession
+	if (bMerged)
+	{
+		for (const FLocalView& View : Views)
+		{
+			if (View.Controller->GetViewTarget() != this)
+				View.Controller->SetViewTarget(this);
+		}
+	}
+
+	// Keep following while split so merging again starts from the right framing
+	const FVector2D Center = Bounds.GetCenter();
+	const FVector CameraOffset = ReferenceCamera->GetComponentLocation() - Views[0].Character->GetActorLocation();
+	const FVector TargetLocation = FVector(Center.X, 0.f, Center.Y) + FVector(0.f, CameraOffset.Y, CameraOffset.Z);
+	const float TargetWidth = FMath::Min(RequiredWidth, MaxOrthoWidth);
+
+	if (bSnapNextUpdate)
+	{
+		SetActorLocationAndRotation(TargetLocation, ReferenceCamera->GetComponentRotation());
+		Camera->OrthoWidth = TargetWidth;
+		bSnapNextUpdate = false;
+	}
+	else
+	{
+		SetActorLocationAndRotation(FMath::VInterpTo(GetActorLocation(), TargetLocation, DeltaSeconds, MoveInterpSpeed), ReferenceCamera->GetComponentRotation());
+		// Zooming out must keep up with the players, zooming in can take its time
+		Camera->OrthoWidth = TargetWidth > Camera->OrthoWidth ? TargetWidth : FMath::FInterpTo(Camera->OrthoWidth, TargetWidth, DeltaSeconds, ZoomInterpSpeed);
+	}
+
+	SET_DWORD_STAT(STAT_SplitscreenViews, bMerged ? 1 : Views.Num());
+}
+
+void ASplitscreenCamera::SetMerged(bool bNewMerged, const TArray<FLocalView>& Views)
+{
+	bMerged = bNewMerged;
+	LastSwitchTime = GetWorld()->GetRealTimeSeconds();
+
+	if (UGameViewportClient* Viewport = GetWorld()->GetGameViewport())
+		Viewport->SetDisableSplitscreenOverride(bMerged);
+
+	for (const FLocalView& View : Views)
+	{
+		if (bMerged)
+			View.Controller->SetViewTargetWithBlend(this, ViewBlendTime);
+		else
+			View.Controller->SetViewTargetWithBlend(View.Character, ViewBlendTime);
+	}
+
+	UE_LOG(SplitscreenCamera, Verbose, TEXT("%s view for %d local players, ortho width %.0f"), bMerged ? TEXT("Shared") : TEXT("Split"), Views.Num(), Camera->OrthoWidth);
+}
+
+void ASplitscreenCamera::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bMerged)
+	{
+		TArray<FLocalView> Views;
+		GatherLocalViews(Views);
+		SetMerged(false, Views);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
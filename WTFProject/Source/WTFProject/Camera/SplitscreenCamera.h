@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "SplitscreenCamera.generated.h"
+
+class UCameraComponent;
+class APlayerController;
+class AWTFProjectCharacter;
+
+/**
+ * Shared orthographic camera for local co-op. While every local player fits in one view, splitscreen is
+ * disabled on the game viewport and all players look through this camera, so the scene is rendered once.
+ * OrthoWidth widens with the distance between the players up to MaxOrthoWidth; beyond that the viewport
+ * splits again and each player gets back the side view camera of their character.
+ *
+ * Spawned by the first character that begins play while more than one local player exists.
+ */
+UCLASS()
+class WTFPROJECT_API ASplitscreenCamera : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ASplitscreenCamera();
+
+	virtual void Tick(float DeltaSeconds) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Spawns the shared camera once per world when there are several local players */
+	static void EnsureForWorld(UWorld* World);
+
+	bool IsMerged() const { return bMerged; }
+
+protected:
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
+	UCameraComponent* Camera = nullptr;
+
+	/** Widest shared view, players further apart than this get their own viewports */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Splitscreen")
+	float MaxOrthoWidth = 4096.f;
+
+	/** Space kept between the outermost players and the screen edges */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Splitscreen")
+	float ScreenMargin = 384.f;
+
+	/** Fraction of MaxOrthoWidth the required width must drop below before a split view merges again */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Splitscreen", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float MergeThreshold = 0.85f;
+
+	/** Minimum seconds between two switches, on top of the width hysteresis */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Splitscreen")
+	float MinSwitchInterval = 0.5f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Splitscreen")
+	float ZoomInterpSpeed = 4.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Splitscreen")
+	float MoveInterpSpeed = 8.f;
+
+	/** View target blend when switching between the shared and the character cameras */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Splitscreen")
+	float ViewBlendTime = 0.2f;
+
+private:
+	struct FLocalView
+	{
+		APlayerController* Controller;
+		AWTFProjectCharacter* Character;
+	};
+
+	void GatherLocalViews(TArray<FLocalView>& OutViews) const;
+	void SetMerged(bool bNewMerged, const TArray<FLocalView>& Views);
+
+	bool bMerged = false;
+	bool bSnapNextUpdate = true;
+	float LastSwitchTime = -MAX_flt;
+};
@@ -0,0 +1,330 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SpriteOverdrawCommandlet.h"
+#include "WTFProjectCharacter.h"
+#include "Objects/Stone.h"
+#include "PaperSprite.h"
+#include "PaperFlipbook.h"
+#include "PaperSpriteComponent.h"
+#include "PaperFlipbookComponent.h"
+#include "Engine/Blueprint.h"
+#include "Engine/Texture2D.h"
+#include "Materials/MaterialInterface.h"
+#include "AssetRegistryModule.h"
+#include "Misc/PackageName.h"
+#include "Misc/Parse.h"
+#include "UObject/Package.h"
+#if WITH_EDITOR
+#include "SpriteEditorOnlyTypes.h"
+#endif
+
+DEFINE_LOG_CATEGORY_STATIC(SpriteOverdraw, Log, All);
+
+USpriteOverdrawCommandlet::USpriteOverdrawCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+#if WITH_EDITOR
+namespace
+{
+	/** Alpha values this close to 0 or 255 still count as binary */
+	const uint8 BinaryAlphaTolerance = 8;
+
+	/** Stock Paper2D translucent materials and the masked ones that look the same on binary alpha */
+	const TCHAR* MaskedReplacements[][2] =
+	{
+		{ TEXT("TranslucentUnlitSpriteMaterial"), TEXT("/Paper2D/MaskedUnlitSpriteMaterial.MaskedUnlitSpriteMaterial") },
+		{ TEXT("TranslucentLitSpriteMaterial"), TEXT("/Paper2D/MaskedLitSpriteMaterial.MaskedLitSpriteMaterial") },
+	};
+
+	/** Editor-only sprite settings without a public setter */
+	template<typename T, typename PropertyType>
+	T* GetSpriteProperty(UPaperSprite* Sprite, const TCHAR* Name)
+	{
+		PropertyType* Property = FindField<PropertyType>(UPaperSprite::StaticClass(), Name);
+		return Property ? Property->template ContainerPtrToValuePtr<T>(Sprite) : nullptr;
+	}
+
+	/** DefaultMaterial of a sprite or flipbook, neither has a setter */
+	UMaterialInterface** GetDefaultMaterialProperty(UObject* Object)
+	{
+		UObjectProperty* Property = FindField<UObjectProperty>(Object->GetClass(), TEXT("DefaultMaterial"));
+		return Property ? Property->ContainerPtrToValuePtr<UMaterialInterface*>(Object) : nullptr;
+	}
+}
+
+void USpriteOverdrawCommandlet::CollectAssets(TArray<UPaperFlipbook*>& OutFlipbooks, TSet<UPaperSprite*>& OutComponentSprites, TArray<UMeshComponent*>& OutComponents) const
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	TArray<FAssetData> Flipbooks;
+	AssetRegistry.GetAssetsByClass(UPaperFlipbook::StaticClass()->GetFName(), Flipbooks, true);
+	for (const FAssetData& Asset : Flipbooks)
+	{
+		if (!Asset.PackageName.ToString().StartsWith(TEXT("/Game/")))
+			continue;
+
+		if (UPaperFlipbook* Flipbook = Cast<UPaperFlipbook>(Asset.GetAsset()))
+			OutFlipbooks.Add(Flipbook);
+	}
+
+	// Stone sprites and the held stone are set on the blueprint defaults of these classes
+	TArray<FAssetData> Blueprints;
+	AssetRegistry.GetAssetsByClass(UBlueprint::StaticClass()->GetFName(), Blueprints, true);
+	for (const FAssetData& Asset : Blueprints)
+	{
+		if (!Asset.PackageName.ToString().StartsWith(TEXT("/Game/")))
+			continue;
+
+		UBlueprint* Blueprint = Cast<UBlueprint>(Asset.GetAsset());
+		UClass* Class = Blueprint ? *Blueprint->GeneratedClass : nullptr;
+		if (!Class || !(Class->IsChildOf(AStone::StaticClass()) || Class->IsChildOf(AWTFProjectCharacter::StaticClass())))
+			continue;
+
+		TArray<UMeshComponent*> Components;
+		Class->GetDefaultObject<AActor>()->GetComponents(Components);
+		for (UMeshComponent* Component : Components)
+		{
+			UPaperSpriteComponent* SpriteComponent = Cast<UPaperSpriteComponent>(Component);
+			if (SpriteComponent && SpriteComponent->GetSprite())
+				OutComponentSprites.Add(SpriteComponent->GetSprite());
+			if (SpriteComponent || Cast<UPaperFlipbookComponent>(Component))
+				OutComponents.Add(Component);
+		}
+	}
+}
+
+bool USpriteOverdrawCommandlet::ComputeAlphaStats(UPaperSprite* Sprite, FAlphaStats& OutStats) const
+{
+	UTexture2D* Texture = Sprite->GetSourceTexture();
+	if (!Texture || Texture->Source.GetFormat() != TSF_BGRA8)
+		return false;
+
+	TArray<uint8> Pixels;
+	Texture->Source.GetMipData(Pixels, 0);
+	const int32 Width = Texture->Source.GetSizeX();
+	const int32 Height = Texture->Source.GetSizeY();
+	if (Pixels.Num() < Width * Height * 4)
+		return false;
+
+	const FVector2D UV = Sprite->GetSourceUV();
+	const FVector2D Size = Sprite->GetSourceSize();
+	const int32 MinX = FMath::Clamp(FMath::FloorToInt(UV.X), 0, Width);
+	const int32 MinY = FMath::Clamp(FMath::FloorToInt(UV.Y), 0, Height);
+	const int32 MaxX = FMath::Clamp(FMath::CeilToInt(UV.X + Size.X), 0, Width);
+	const int32 MaxY = FMath::Clamp(FMath::CeilToInt(UV.Y + Size.Y), 0, Height);
+	const uint8 TransparentAlpha = (uint8)FMath::Clamp(FMath::RoundToInt(AlphaThreshold * 255.f), 0, 255);
+
+	for (int32 Y = MinY; Y < MaxY; Y++)
+	{
+		for (int32 X = MinX; X < MaxX; X++)
+		{
+			const uint8 Alpha = Pixels[(Y * Width + X) * 4 + 3];
+			OutStats.NumPixels++;
+			if (Alpha <= TransparentAlpha)
+				OutStats.NumTransparent++;
+			if (Alpha > BinaryAlphaTolerance && Alpha < 255 - BinaryAlphaTolerance)
+				OutStats.NumPartial++;
+		}
+	}
+	return OutStats.NumPixels > 0;
+}
+
+FString USpriteOverdrawCommandlet::SwapToMasked(UObject* Object, UMaterialInterface*& Material, bool bBinaryAlpha, TSet<UPackage*>& ChangedPackages, int32& NumMasked) const
+{
+	if (!Material)
+		return TEXT("no material");
+
+	// Translucent pixels that are fully opaque or fully clear blend to the same result as a masked test
+	if (!bBinaryAlpha || Material->GetBlendMode() != BLEND_Translucent)
+		return Material->GetName();
+
+	UMaterialInterface* Masked = nullptr;
+	for (const auto& Replacement : MaskedReplacements)
+	{
+		if (Material->GetName() == Replacement[0])
+			Masked = LoadObject<UMaterialInterface>(nullptr, Replacement[1]);
+	}
+	if (!Masked)
+		return Material->GetName() + TEXT(" (custom translucent, left as is)");
+
+	const FString Note = FString::Printf(TEXT("%s -> %s"), *Material->GetName(), *Masked->GetName());
+	Object->Modify();
+	Material = Masked;
+	ChangedPackages.Add(Object->GetOutermost());
+	NumMasked++;
+	return Note;
+}
+
+float USpriteOverdrawCommandlet::GetRenderedPixels(UPaperSprite* Sprite) const
+{
+	const TArray<FVector4>* Triangles = GetSpriteProperty<TArray<FVector4>, UArrayProperty>(Sprite, TEXT("BakedRenderData"));
+	UTexture2D* Texture = Sprite->GetBakedTexture() ? Sprite->GetBakedTexture() : Sprite->GetSourceTexture();
+	if (!Triangles || !Texture)
+		return 0.f;
+
+	// Vertices are (X, Y, U, V), measure in texels so sprites of any pixels per unit compare
+	const float TexelArea = (float)Texture->Source.GetSizeX() * Texture->Source.GetSizeY();
+	float Area = 0.f;
+	for (int32 i = 0; i + 2 < Triangles->Num(); i += 3)
+	{
+		const FVector2D A((*Triangles)[i].Z, (*Triangles)[i].W);
+		const FVector2D B((*Triangles)[i + 1].Z, (*Triangles)[i + 1].W);
+		const FVector2D C((*Triangles)[i + 2].Z, (*Triangles)[i + 2].W);
+		Area += FMath::Abs(FVector2D::CrossProduct(B - A, C - A)) * 0.5f;
+	}
+	return Area * TexelArea;
+}
+#endif
+
+int32 USpriteOverdrawCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	const bool bSave = FParse::Param(*Params, TEXT("save"));
+	FParse::Value(*Params, TEXT("alphathreshold="), AlphaThreshold);
+	FParse::Value(*Params, TEXT("detail="), DetailAmount);
+
+	TArray<UPaperFlipbook*> Flipbooks;
+	TSet<UPaperSprite*> ComponentSprites;
+	TArray<UMeshComponent*> Components;
+	CollectAssets(Flipbooks, ComponentSprites, Components);
+
+	TSet<UPaperSprite*> Sprites = ComponentSprites;
+	for (UPaperFlipbook* Flipbook : Flipbooks)
+	{
+		for (int32 i = 0; i < Flipbook->GetNumKeyFrames(); i++)
+		{
+			if (UPaperSprite* Sprite = Flipbook->GetKeyFrameChecked(i).Sprite)
+				Sprites.Add(Sprite);
+		}
+	}
+	UE_LOG(SpriteOverdraw, Display, TEXT("%d sprites referenced by %d flipbooks and %d stone and character components"), Sprites.Num(), Flipbooks.Num(), Components.Num());
+
+	double PixelsBefore = 0.0;
+	double PixelsAfter = 0.0;
+	int32 NumRebuilt = 0;
+	int32 NumMasked = 0;
+	TSet<UPackage*> ChangedPackages;
+	TMap<UPaperSprite*, bool> BinaryAlpha;
+	for (UPaperSprite* Sprite : Sprites)
+	{
+		FAlphaStats Stats;
+		if (!ComputeAlphaStats(Sprite, Stats))
+		{
+			UE_LOG(SpriteOverdraw, Warning, TEXT("%s: source texture missing or not BGRA8, skipped"), *Sprite->GetPathName());
+			continue;
+		}
+
+		const float Before = GetRenderedPixels(Sprite);
+		FSpriteGeometryCollection* Geometry = GetSpriteProperty<FSpriteGeometryCollection, UStructProperty>(Sprite, TEXT("RenderGeometry"));
+		if (Geometry && Geometry->GeometryType != ESpritePolygonMode::ShrinkWrapped && Geometry->GeometryType != ESpritePolygonMode::FullyCustom)
+		{
+			Sprite->Modify();
+			Geometry->GeometryType = ESpritePolygonMode::ShrinkWrapped;
+			Geometry->AlphaThreshold = AlphaThreshold;
+			Geometry->DetailAmount = DetailAmount;
+			Sprite->RebuildRenderData();
+			ChangedPackages.Add(Sprite->GetOutermost());
+			NumRebuilt++;
+		}
+		const float After = GetRenderedPixels(Sprite);
+
+		const bool bBinaryAlpha = Stats.NumPartial == 0;
+		BinaryAlpha.Add(Sprite, bBinaryAlpha);
+
+		// Only sprite components draw with the sprite's own material, flipbook components never do
+		FString MaterialNote = TEXT("material taken from the flipbook");
+		UMaterialInterface** Material = GetDefaultMaterialProperty(Sprite);
+		if (ComponentSprites.Contains(Sprite) && Material)
+			MaterialNote = SwapToMasked(Sprite, *Material, bBinaryAlpha, ChangedPackages, NumMasked);
+
+		PixelsBefore += Before;
+		PixelsAfter += After;
+		UE_LOG(SpriteOverdraw, Display, TEXT("%s: %.0f%% transparent, %s alpha, %.0f -> %.0f texels drawn, %s"), *Sprite->GetPathName(),
+			100.f * Stats.NumTransparent / Stats.NumPixels, bBinaryAlpha ? TEXT("binary") : TEXT("soft"), Before, After, *MaterialNote);
+	}
+
+	// A flipbook can be masked only if every one of its frames can, sprites that were skipped count as soft
+	auto IsBinaryFlipbook = [&BinaryAlpha](const UPaperFlipbook* Flipbook)
+	{
+		for (int32 i = 0; i < Flipbook->GetNumKeyFrames(); i++)
+		{
+			UPaperSprite* Sprite = Flipbook->GetKeyFrameChecked(i).Sprite;
+			if (Sprite && !BinaryAlpha.FindRef(Sprite))
+				return false;
+		}
+		return Flipbook->GetNumKeyFrames() > 0;
+	};
+
+	for (UPaperFlipbook* Flipbook : Flipbooks)
+	{
+		if (UMaterialInterface** Material = GetDefaultMaterialProperty(Flipbook))
+		{
+			const FString MaterialNote = SwapToMasked(Flipbook, *Material, IsBinaryFlipbook(Flipbook), ChangedPackages, NumMasked);
+			UE_LOG(SpriteOverdraw, Display, TEXT("%s: %d frames, %s"), *Flipbook->GetPathName(), Flipbook->GetNumKeyFrames(), *MaterialNote);
+		}
+	}
+
+	// A material set on the component is used instead of the sprite's or the flipbook's
+	for (UMeshComponent* Component : Components)
+	{
+		if (Component->OverrideMaterials.Num() == 0 || !Component->OverrideMaterials[0])
+			continue;
+
+		bool bBinaryAlpha = false;
+		if (UPaperSpriteComponent* SpriteComponent = Cast<UPaperSpriteComponent>(Component))
+		{
+			bBinaryAlpha = BinaryAlpha.FindRef(SpriteComponent->GetSprite());
+		}
+		else if (UPaperFlipbookComponent* FlipbookComponent = Cast<UPaperFlipbookComponent>(Component))
+		{
+			// Characters play the flipbooks of all their animation states on this component
+			TArray<UPaperFlipbook*> Played;
+			Played.Add(FlipbookComponent->GetFlipbook());
+			if (const AWTFProjectCharacter* Character = Cast<AWTFProjectCharacter>(Component->GetOuter()))
+			{
+				for (const auto& State : Character->AnimationStates)
+					Played.Append(State.Value.Animations);
+			}
+
+			bBinaryAlpha = true;
+			for (const UPaperFlipbook* Flipbook : Played)
+			{
+				if (Flipbook && !IsBinaryFlipbook(Flipbook))
+					bBinaryAlpha = false;
+			}
+		}
+
+		const FString MaterialNote = SwapToMasked(Component, Component->OverrideMaterials[0], bBinaryAlpha, ChangedPackages, NumMasked);
+		UE_LOG(SpriteOverdraw, Display, TEXT("%s: override material %s"), *Component->GetPathName(), *MaterialNote);
+	}
+
+	int32 NumSaved = 0;
+	if (bSave)
+	{
+		for (UPackage* Package : ChangedPackages)
+		{
+			Package->MarkPackageDirty();
+			const FString FileName = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+			if (UPackage::SavePackage(Package, nullptr, RF_Standalone, *FileName))
+				NumSaved++;
+			else
+				UE_LOG(SpriteOverdraw, Error, TEXT("Failed to save %s"), *FileName);
+		}
+	}
+
+	const double Reduction = PixelsBefore > 0.0 ? 100.0 * (1.0 - PixelsAfter / PixelsBefore) : 0.0;
+	UE_LOG(SpriteOverdraw, Display, TEXT("Rebuilt %d sprites, %d materials switched to masked, %d packages saved%s"), NumRebuilt, NumMasked, NumSaved,
+		bSave ? TEXT("") : TEXT(" (dry run, pass -save to keep the changes)"));
+	UE_LOG(SpriteOverdraw, Display, TEXT("Estimated fill for drawing every sprite once: %.0f -> %.0f texels, %.1f%% less overdraw"), PixelsBefore, PixelsAfter, Reduction);
+	return 0;
+#else
+	UE_LOG(SpriteOverdraw, Error, TEXT("SpriteOverdraw needs the editor"));
+	return 1;
+#endif
+}
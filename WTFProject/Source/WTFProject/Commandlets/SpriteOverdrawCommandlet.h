@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SpriteOverdrawCommandlet.generated.h"
+
+class UPaperSprite;
+class UPaperFlipbook;
+class UMeshComponent;
+class UMaterialInterface;
+
+/**
+ * Audits the fill cost of every sprite used by the game's flipbooks and by the sprite components of
+ * stone and character blueprints. For each sprite it reports how much of its frame is transparent and
+ * rebuilds the render geometry as a shrink-wrapped polygon around the opaque pixels.
+ *
+ * Stock translucent Paper2D materials are swapped for their masked versions where the alpha is only on
+ * or off, on the object the renderer takes the material from: the flipbook for flipbook components,
+ * the sprite for sprite components, and the component itself where it overrides the material.
+ *
+ * Usage: UE4Editor-Cmd WTFProject.uproject -run=SpriteOverdraw [-save] [-alphathreshold=0..1] [-detail=0..1]
+ * Without -save only the report is printed.
+ */
+UCLASS()
+class WTFPROJECT_API USpriteOverdrawCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USpriteOverdrawCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+#if WITH_EDITOR
+private:
+	struct FAlphaStats
+	{
+		int32 NumPixels = 0;
+		int32 NumTransparent = 0;
+		int32 NumPartial = 0;
+	};
+
+	/** Game flipbooks, the sprites of sprite components and all sprite and flipbook components of stone and character blueprints */
+	void CollectAssets(TArray<UPaperFlipbook*>& OutFlipbooks, TSet<UPaperSprite*>& OutComponentSprites, TArray<UMeshComponent*>& OutComponents) const;
+	bool ComputeAlphaStats(UPaperSprite* Sprite, FAlphaStats& OutStats) const;
+
+	/** Sets a stock translucent material property to its masked version, returns the note for the report */
+	FString SwapToMasked(UObject* Object, UMaterialInterface*& Material, bool bBinaryAlpha, TSet<UPackage*>& ChangedPackages, int32& NumMasked) const;
+
+	/** Pixels covered by the baked render triangles */
+	float GetRenderedPixels(UPaperSprite* Sprite) const;
+
+	float AlphaThreshold = 0.f;
+	float DetailAmount = 0.5f;
+#endif
+};
@@ -0,0 +1,152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CharacterMovement2D.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(Movement2D, Log, All);
+
+static TAutoConsoleVariable<int32> CVarMovement2D(
+	TEXT("wtf.Movement2D"),
+	1,
+	TEXT("1 uses the plane-constrained floor check and idle floor reuse of UCharacterMovement2D, 0 the generic character movement."));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdMovementBenchmark(
+	TEXT("wtf.Movement.Benchmark"),
+	TEXT("wtf.Movement.Benchmark [Characters=64] [Frames=600]: times walking and jumping characters with wtf.Movement2D 0 and 1."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 64;
+		const int32 Frames = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 600;
+		UCharacterMovement2D::RunBenchmark(World, Count, Frames);
+	}));
+
+void UCharacterMovement2D::ApplyMode(bool bUse2D)
+{
+	AppliedMode = bUse2D ? 1 : 0;
+	bAlwaysCheckFloor = !bUse2D;
+	bEnablePhysicsInteraction = !bUse2D;
+}
+
+void UCharacterMovement2D::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	const bool bUse2D = CVarMovement2D.GetValueOnGameThread() != 0;
+	if (AppliedMode != (bUse2D ? 1 : 0))
+		ApplyMode(bUse2D);
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+}
+
+void UCharacterMovement2D::ComputeFloorDist(const FVector& CapsuleLocation, float LineDistance, float SweepDistance, FFindFloorResult& OutFloorResult, float SweepRadius, const FHitResult* DownwardSweepResult) const
+{
+	// A downward hit from the move itself is reused by the generic check without tracing again
+	if (CVarMovement2D.GetValueOnGameThread() == 0 || !CharacterOwner || !UpdatedComponent || (DownwardSweepResult && DownwardSweepResult->IsValidBlockingHit()))
+	{
+		Super::ComputeFloorDist(CapsuleLocation, LineDistance, SweepDistance, OutFloorResult, SweepRadius, DownwardSweepResult);
+		return;
+	}
+
+	float PawnRadius, PawnHalfHeight;
+	CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleSize(PawnRadius, PawnHalfHeight);
+
+	// Same shrunken height as the generic check, so the floor distances it computes are the same
+	const float ShrinkHeight = (PawnHalfHeight - PawnRadius) * 0.1f;
+	const float TraceDist = SweepDistance + ShrinkHeight;
+	const FCollisionShape Box = FCollisionShape::MakeBox(FVector(SweepRadius * 0.707f, 1.f, PawnHalfHeight - ShrinkHeight));
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ComputeFloorDist2D), false, CharacterOwner);
+	FCollisionResponseParams ResponseParam;
+	InitCollisionParams(QueryParams, ResponseParam);
+
+	FHitResult Hit(1.f);
+	const bool bBlockingHit = GetWorld()->SweepSingleByChannel(Hit, CapsuleLocation, CapsuleLocation + FVector(0.f, 0.f, -TraceDist), FQuat::Identity,
+		UpdatedComponent->GetCollisionObjectType(), Box, QueryParams, ResponseParam);
+
+	// Nothing under the box, the generic check skips its line trace in that case too
+	if (!bBlockingHit)
+	{
+		OutFloorResult.Clear();
+		return;
+	}
+
+	const float FloorDist = FMath::Max(-FMath::Max(MAX_FLOOR_DIST, PawnRadius), Hit.Time * TraceDist - ShrinkHeight);
+	if (Hit.bStartPenetrating || !IsWalkable(Hit) || FloorDist > SweepDistance)
+	{
+		Super::ComputeFloorDist(CapsuleLocation, LineDistance, SweepDistance, OutFloorResult, SweepRadius, DownwardSweepResult);
+		return;
+	}
+
+	OutFloorResult.SetFromSweep(Hit, FloorDist, true);
+}
+
+void UCharacterMovement2D::RunBenchmark(UWorld* World, int32 Count, int32 Frames)
+{
+	APlayerController* PlController = World ? World->GetFirstPlayerController() : nullptr;
+	APawn* Template = PlController ? PlController->GetPawn() : nullptr;
+	if (!Template || Count <= 0 || Frames <= 0)
+	{
+		UE_LOG(Movement2D, Warning, TEXT("Movement benchmark needs a player pawn to copy"));
+		return;
+	}
+
+	FActorSpawnParameters Params;
+	Params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	TArray<ACharacter*> Characters;
+	TArray<FVector> StartLocations;
+	for (int32 i = 0; i < Count; i++)
+	{
+		const FVector Location = Template->GetActorLocation() + FVector((i - Count / 2) * 150.f, 0.f, 200.f);
+		ACharacter* Character = World->SpawnActor<ACharacter>(Template->GetClass(), Location, FRotator::ZeroRotator, Params);
+		if (!Character)
+			continue;
+
+		Character->SpawnDefaultController();
+		Characters.Add(Character);
+		StartLocations.Add(Character->GetActorLocation());
+	}
+
+	IConsoleVariable* Mode = CVarMovement2D.AsVariable();
+	const int32 SavedMode = Mode->GetInt();
+	const float DeltaTime = 1.f / 60.f;
+	double Seconds[2] = { 0.0, 0.0 };
+	for (int32 Use2D = 0; Use2D < 2; Use2D++)
+	{
+		Mode->Set(Use2D, ECVF_SetByConsole);
+		for (int32 i = 0; i < Characters.Num(); i++)
+		{
+			Characters[i]->SetActorLocation(StartLocations[i], false, nullptr, ETeleportType::TeleportPhysics);
+			Characters[i]->GetCharacterMovement()->StopMovementImmediately();
+			Characters[i]->GetCharacterMovement()->SetMovementMode(MOVE_Falling);
+		}
+
+		// Everyone walks back and forth a second at a time and jumps every 1.5s, staggered
+		const double Start = FPlatformTime::Seconds();
+		for (int32 Frame = 0; Frame < Frames; Frame++)
+		{
+			for (int32 i = 0; i < Characters.Num(); i++)
+			{
+				UCharacterMovementComponent* Movement = Characters[i]->GetCharacterMovement();
+				Movement->AddInputVector(FVector(((Frame / 60 + i) & 1) ? 1.f : -1.f, 0.f, 0.f));
+				if ((Frame + i) % 90 == 0)
+					Characters[i]->Jump();
+				Movement->TickComponent(DeltaTime, LEVELTICK_All, nullptr);
+			}
+		}
+		Seconds[Use2D] = FPlatformTime::Seconds() - Start;
+	}
+	Mode->Set(SavedMode, ECVF_SetByConsole);
+
+	for (ACharacter* Character : Characters)
+	{
+		if (AController* Controller = Character->GetController())
+			Controller->Destroy();
+		Character->Destroy();
+	}
+
+	const double Steps = (double)FMath::Max(Characters.Num(), 1) * Frames;
+	UE_LOG(Movement2D, Display, TEXT("Movement benchmark, %d characters, %d frames: generic %.2fus, 2D %.2fus per character per frame (%.0f%% less)"),
+		Characters.Num(), Frames, Seconds[0] * 1e6 / Steps, Seconds[1] * 1e6 / Steps, Seconds[0] > 0.0 ? 100.0 * (1.0 - Seconds[1] / Seconds[0]) : 0.0);
+}
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "CharacterMovement2D.generated.h"
+
+/**
+ * Character movement for characters locked to the XZ plane. Walking, jumping, falling, air control and
+ * the network prediction path are the engine's, with the same tuning; what changes is the work that
+ * only makes sense in 3D:
+ * - the floor is found with one box sweep as wide as the capsule and one unit deep on the locked axis,
+ *   instead of capsule sweeps (and two rotated box sweeps for a flat base) plus a line trace. Anything
+ *   unusual, like starting inside geometry or landing on an unwalkable edge, goes to the generic check.
+ * - idle characters reuse their floor instead of checking it every frame.
+ * - no physics interaction, there are no simulated bodies to push.
+ *
+ * wtf.Movement2D 0 switches all of it back to the generic behaviour at runtime.
+ */
+UCLASS()
+class WTFPROJECT_API UCharacterMovement2D : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void ComputeFloorDist(const FVector& CapsuleLocation, float LineDistance, float SweepDistance, FFindFloorResult& OutFloorResult, float SweepRadius, const FHitResult* DownwardSweepResult = NULL) const override;
+
+	/** Spawns Count characters of the first player's class and times their movement with the 2D path off and on */
+	static void RunBenchmark(UWorld* World, int32 Count, int32 Frames);
+
+private:
+	void ApplyMode(bool bUse2D);
+
+	int32 AppliedMode = INDEX_NONE;
+};
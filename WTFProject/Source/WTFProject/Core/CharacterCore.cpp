@@ -0,0 +1,387 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CharacterCore.h"
+#include <cmath>
+
+namespace WTFCore
+{
+	namespace
+	{
+		const float RadToDeg = 57.2957795f;
+
+		float Sign(float Value)
+		{
+			return Value > 0.f ? 1.f : (Value < 0.f ? -1.f : 0.f);
+		}
+
+		uint8_t ReasonBit(EMovementBlockReason Reason)
+		{
+			return (uint8_t)(1 << (uint8_t)Reason);
+		}
+
+		bool IsOneShotAnimation(EAnimationState State)
+		{
+			return State == EAnimationState::ThrowUp ||
+				State == EAnimationState::ThrowFront ||
+				State == EAnimationState::ThrowDown ||
+				State == EAnimationState::Pick ||
+				State == EAnimationState::Hit;
+		}
+	}
+
+	void FCharacterRules::Reset(FCharacterState& State, const FCharacterTuning& Tuning)
+	{
+		State = FCharacterState();
+		State.Ammo = Tuning.InitialAmmo;
+	}
+
+	bool FCharacterRules::CanMove(const FCharacterState& State)
+	{
+		return State.NumMovementBlocks == 0;
+	}
+
+	bool FCharacterRules::CanJump(const FCharacterState& State, const FCharacterContext& Context)
+	{
+		return CanMove(State) && !Context.bFalling;
+	}
+
+	bool FCharacterRules::CanPick(const FCharacterState& /*State*/, const FCharacterContext& Context)
+	{
+		return !Context.bFalling;
+	}
+
+	bool FCharacterRules::CanAim(const FCharacterState& State, const FCharacterContext& Context)
+	{
+		return !Context.bFalling && State.Ammo > 0 && !State.bThrowing;
+	}
+
+	bool FCharacterRules::CanThrow(const FCharacterState& State, const FCharacterContext& Context)
+	{
+		return !Context.bFalling && State.Ammo > 0 && !State.bThrowing && State.bIsAiming;
+	}
+
+	void FCharacterRules::Jump(FCharacterState& State, const FCharacterContext& Context, const FCharacterTuning& Tuning, FCharacterEvents& Events)
+	{
+		Events.Add(CharacterEvents::Jump);
+		SetAnimationState(State, Context, Tuning, ESimpleAnimationState::Jump, Events);
+	}
+
+	void FCharacterRules::PickStone(FCharacterState& State, const FCharacterContext& Context, const FCharacterTuning& Tuning, FCharacterEvents& Events)
+	{
+		if (State.Ammo == 0)
+			Events.Add(CharacterEvents::AttachStone);
+		State.Ammo++;
+
+		Events.Add(CharacterEvents::StopMovement);
+		FMovementBlock Block;
+		Block.bTimed = true;
+		Block.Reason = EMovementBlockReason::Pick;
+		Block.Time = Tuning.PickBlockTime;
+		AddMovementBlock(State, Block, Events);
+		SetAnimationState(State, Context, Tuning, ESimpleAnimationState::Pick, Events);
+	}
+
+	void FCharacterRules::Aim(FCharacterState& State, const FCharacterContext& Context)
+	{
+		if (CanAim(State, Context))
+			State.bIsAiming = true;
+	}
+
+	void FCharacterRules::StopAim(FCharacterState& State)
+	{
+		State.bIsAiming = false;
+	}
+
+	bool FCharacterRules::Throw(FCharacterState& State, const FCharacterContext& Context, const FCharacterTuning& Tuning, const FVec2& Direction, FCharacterEvents& Events)
+	{
+		if (!CanThrow(State, Context))
+			return false;
+
+		State.ThrowDirection = Direction;
+		Events.Add(CharacterEvents::StopMovement);
+		State.bThrowing = true;
+		StopAim(State);
+
+		FMovementBlock Block;
+		Block.Reason = EMovementBlockReason::Throw;
+		Block.bTimed = true;
+		Block.Time = Tuning.ThrowTimer;
+		State.ThrowTimerCurrent = Tuning.ThrowTimer;
+		AddMovementBlock(State, Block, Events);
+		SetAnimationState(State, Context, Tuning, ESimpleAnimationState::Throw, Events);
+		return true;
+	}
+
+	void FCharacterRules::ReleaseThrow(FCharacterState& State, const FCharacterContext& Context, FCharacterEvents& Events)
+	{
+		State.bThrowing = false;
+		if (!Context.bCanLaunchStone)
+			return;
+
+		State.Ammo--;
+		if (State.Ammo == 0)
+			Events.Add(CharacterEvents::DetachStone);
+		Events.Add(CharacterEvents::LaunchStone);
+	}
+
+	void FCharacterRules::AddMovementBlock(FCharacterState& State, const FMovementBlock& Block, FCharacterEvents& Events)
+	{
+		// One block per reason, a new one replaces the old
+		int32_t i = 0;
+		while (i < State.NumMovementBlocks && State.MovementBlocks[i].Reason != Block.Reason)
+			i++;
+
+		if (i == State.NumMovementBlocks)
+			State.NumMovementBlocks++;
+		State.MovementBlocks[i] = Block;
+		Events.BlocksAdded |= ReasonBit(Block.Reason);
+	}
+
+	void FCharacterRules::RemoveMovementBlock(FCharacterState& State, EMovementBlockReason Reason, FCharacterEvents& Events)
+	{
+		for (int32_t i = 0; i < State.NumMovementBlocks; i++)
+		{
+			if (State.MovementBlocks[i].Reason == Reason)
+			{
+				for (int32_t j = i + 1; j < State.NumMovementBlocks; j++)
+					State.MovementBlocks[j - 1] = State.MovementBlocks[j];
+				State.NumMovementBlocks--;
+				Events.BlocksRemoved |= ReasonBit(Reason);
+				return;
+			}
+		}
+	}
+
+	void FCharacterRules::UpdateMovementBlocks(FCharacterState& State, float DeltaTime, FCharacterEvents& Events)
+	{
+		int32_t Kept = 0;
+		for (int32_t i = 0; i < State.NumMovementBlocks; i++)
+		{
+			FMovementBlock& Block = State.MovementBlocks[i];
+			if (Block.bTimed)
+			{
+				Block.Time -= DeltaTime;
+				if (Block.Time <= 0.f)
+				{
+					Events.BlocksRemoved |= ReasonBit(Block.Reason);
+					continue;
+				}
+			}
+			State.MovementBlocks[Kept++] = Block;
+		}
+		State.NumMovementBlocks = Kept;
+	}
+
+	void FCharacterRules::SetFacing(FCharacterState& State, bool bRight, FCharacterEvents& Events)
+	{
+		State.bFacingRight = bRight;
+		Events.Add(CharacterEvents::FacingChanged);
+	}
+
+	void FCharacterRules::Update(FCharacterState& State, const FCharacterContext& Context, const FCharacterTuning& Tuning, float DeltaTime, FCharacterEvents& Events)
+	{
+		if (State.bIsAiming && !CanAim(State, Context))
+			StopAim(State);
+
+		if (State.bThrowing)
+		{
+			State.ThrowTimerCurrent -= DeltaTime;
+			if (State.ThrowTimerCurrent <= 0.f)
+				ReleaseThrow(State, Context, Events);
+		}
+
+		if (Context.bControlsFacing)
+		{
+			if (State.bIsAiming)
+			{
+				if (Context.bAimValid)
+					SetFacing(State, State.AimDirection.X >= 0.f, Events);
+			}
+			else if (Context.Velocity.X < 0.f)
+				SetFacing(State, false, Events);
+			else if (Context.Velocity.X > 0.f)
+				SetFacing(State, true, Events);
+		}
+
+		UpdateAnimationState(State, Context, Tuning, Events);
+	}
+
+	void FCharacterRules::UpdateAnimationState(FCharacterState& State, const FCharacterContext& Context, const FCharacterTuning& Tuning, FCharacterEvents& Events)
+	{
+		if (State.bIsAiming)
+			SetAnimationState(State, Context, Tuning, ESimpleAnimationState::Aim, Events);
+		else if (Context.Velocity.SizeSquared() > 0.f)
+			SetAnimationState(State, Context, Tuning, Context.bFalling ? ESimpleAnimationState::Fall : ESimpleAnimationState::Walk, Events);
+		else
+			SetAnimationState(State, Context, Tuning, ESimpleAnimationState::Idle, Events);
+	}
+
+	int32_t FCharacterRules::GetAimSector(const FCharacterState& State, const FCharacterContext& Context, const FCharacterTuning& Tuning)
+	{
+		const float Dot = Context.Forward.Dot(State.AimDirection);
+		const float AimAngle = std::acos(Dot < -1.f ? -1.f : (Dot > 1.f ? 1.f : Dot)) * RadToDeg * Sign(State.AimDirection.Z);
+		if (AimAngle > Tuning.AimSectorDegrees)
+			return 1;
+		if (AimAngle < -Tuning.AimSectorDegrees)
+			return -1;
+		return 0;
+	}
+
+	void FCharacterRules::SetAnimationState(FCharacterState& State, const FCharacterContext& Context, const FCharacterTuning& Tuning, ESimpleAnimationState NewState, FCharacterEvents& Events)
+	{
+		const EAnimationState OldState = State.AnimationState;
+		const bool bCarry = State.Ammo > 0;
+		bool SetReverse = false;
+		bool SameFrame = false;
+
+		switch (NewState)
+		{
+		case ESimpleAnimationState::Idle:
+		{
+			// One-shot animations return to idle by themselves when they finish
+			if (!IsOneShotAnimation(State.AnimationState))
+				State.AnimationState = bCarry ? EAnimationState::CarryIdle : EAnimationState::Idle;
+			break;
+		}
+		case ESimpleAnimationState::Fall:
+		{
+			if (State.AnimationState != EAnimationState::Jump && State.AnimationState != EAnimationState::CarryJump)
+				State.AnimationState = bCarry ? EAnimationState::CarryFall : EAnimationState::Fall;
+			break;
+		}
+		case ESimpleAnimationState::Aim:
+		{
+			// Walking away from the aim direction plays the walk backwards
+			const float VelocityXSign = Sign(Context.Velocity.X);
+			const bool AimWalkSameSide = VelocityXSign == 0.f || VelocityXSign == Sign(State.AimDirection.X);
+			if (AimWalkSameSide && State.bIsReversing)
+			{
+				State.bIsReversing = false;
+				Events.Add(CharacterEvents::PlayForward);
+			}
+			else if (!AimWalkSameSide && !State.bIsReversing)
+			{
+				State.bIsReversing = true;
+				SetReverse = true;
+				Events.Add(CharacterEvents::PlayReverse);
+			}
+
+			const bool bWalking = Context.Velocity.SizeSquared() > 0.f;
+			SameFrame = bWalking;
+			switch (GetAimSector(State, Context, Tuning))
+			{
+			case 1:
+				State.AnimationState = bWalking ? EAnimationState::WalkAimingUp : EAnimationState::AimingUp;
+				break;
+			case -1:
+				State.AnimationState = bWalking ? EAnimationState::WalkAimingDown : EAnimationState::AimingDown;
+				break;
+			default:
+				State.AnimationState = bWalking ? EAnimationState::WalkAimingFront : EAnimationState::AimingFront;
+				break;
+			}
+			break;
+		}
+		case ESimpleAnimationState::Jump:
+		{
+			State.AnimationState = bCarry ? EAnimationState::CarryJump : EAnimationState::Jump;
+			break;
+		}
+		case ESimpleAnimationState::Pick:
+		{
+			State.AnimationState = EAnimationState::Pick;
+			break;
+		}
+		case ESimpleAnimationState::Throw:
+		{
+			const int32_t Sector = GetAimSector(State, Context, Tuning);
+			State.AnimationState = Sector > 0 ? EAnimationState::ThrowUp : (Sector < 0 ? EAnimationState::ThrowDown : EAnimationState::ThrowFront);
+			break;
+		}
+		case ESimpleAnimationState::Walk:
+		{
+			State.AnimationState = bCarry ? EAnimationState::CarryWalk : EAnimationState::Walk;
+			break;
+		}
+		}
+
+		if (OldState != State.AnimationState)
+		{
+			if (State.bIsReversing && !SetReverse)
+			{
+				State.bIsReversing = false;
+				Events.Add(CharacterEvents::PlayForward);
+			}
+			Events.Add(CharacterEvents::AnimationChanged);
+			if (SameFrame)
+				Events.Add(CharacterEvents::SameFrame);
+		}
+	}
+
+	void FCharacterRules::FinishAnimation(FCharacterState& State, const FCharacterContext& Context, const FCharacterTuning& Tuning, FCharacterEvents& Events)
+	{
+		// Going through Walk forces the state change even if the target state was already set
+		if (IsOneShotAnimation(State.AnimationState))
+		{
+			State.AnimationState = EAnimationState::Walk;
+			SetAnimationState(State, Context, Tuning, ESimpleAnimationState::Idle, Events);
+		}
+		else if (State.AnimationState == EAnimationState::Jump || State.AnimationState == EAnimationState::CarryJump)
+		{
+			State.AnimationState = EAnimationState::Walk;
+			SetAnimationState(State, Context, Tuning, ESimpleAnimationState::Fall, Events);
+		}
+		else if (State.AnimationState != EAnimationState::AimingDown &&
+			State.AnimationState != EAnimationState::AimingFront &&
+			State.AnimationState != EAnimationState::AimingUp)
+		{
+			Events.Add(CharacterEvents::RestartFlipbook);
+		}
+	}
+
+	void FHeadlessCharacter::Step(const FCharacterTuning& Tuning, const FHeadlessInput& Input, float DeltaTime)
+	{
+		FCharacterEvents Events;
+		FCharacterContext Context;
+		Context.Velocity = Velocity;
+		Context.Forward = FVec2(State.bFacingRight ? 1.f : -1.f, 0.f);
+		Context.bFalling = Location.Z > 0.f || Velocity.Z > 0.f;
+
+		// Aim before the buttons, a throw released this step goes where the player aims this step
+		State.AimDirection = Input.Aim;
+		if (Input.bJump && !PreviousInput.bJump && FCharacterRules::CanJump(State, Context))
+		{
+			FCharacterRules::Jump(State, Context, Tuning, Events);
+			Velocity.Z = JumpZVelocity;
+		}
+		if (Input.bPick && !PreviousInput.bPick && FCharacterRules::CanPick(State, Context))
+			FCharacterRules::PickStone(State, Context, Tuning, Events);
+		if (Input.bAim && !PreviousInput.bAim)
+			FCharacterRules::Aim(State, Context);
+		else if (!Input.bAim && PreviousInput.bAim)
+			FCharacterRules::Throw(State, Context, Tuning, State.AimDirection, Events);
+		if (Events.Has(CharacterEvents::StopMovement))
+			Velocity = FVec2();
+
+		FCharacterRules::UpdateMovementBlocks(State, DeltaTime, Events);
+		FCharacterRules::Update(State, Context, Tuning, DeltaTime, Events);
+		if (Events.Has(CharacterEvents::LaunchStone))
+			StonesThrown++;
+
+		// Walking is instant, falling keeps the horizontal speed
+		if (!Context.bFalling)
+			Velocity.X = FCharacterRules::CanMove(State) ? Input.MoveAxis * MaxWalkSpeed : 0.f;
+		else
+			Velocity.Z += Gravity * DeltaTime;
+
+		Location.X += Velocity.X * DeltaTime;
+		Location.Z += Velocity.Z * DeltaTime;
+		if (Location.Z <= 0.f && Velocity.Z <= 0.f)
+		{
+			Location.Z = 0.f;
+			Velocity.Z = 0.f;
+		}
+
+		PreviousInput = Input;
+	}
+}
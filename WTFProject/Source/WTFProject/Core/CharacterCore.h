@@ -0,0 +1,230 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// Plain C++ on purpose: no engine headers, so the rules also build into tools and tests outside the engine
+
+#include <cstdint>
+
+namespace WTFCore
+{
+	/** Mirrors EMovementBlockReason */
+	enum class EMovementBlockReason : uint8_t
+	{
+		Pick,
+		Aim,
+		Throw,
+
+		Count
+	};
+
+	/** Mirrors ESimpleAnimationState */
+	enum class ESimpleAnimationState : uint8_t
+	{
+		Idle,
+		Walk,
+		Jump,
+		Fall,
+		Aim,
+		Throw,
+		Pick
+	};
+
+	/** Mirrors EAnimationState, the values are the flipbook keys of the character */
+	enum class EAnimationState : uint8_t
+	{
+		Idle,
+		Walk,
+		CarryIdle,
+		CarryWalk,
+		CarryFall,
+		CarryJump,
+		AimingUp,
+		AimingDown,
+		AimingFront,
+		WalkAimingUp,
+		WalkAimingDown,
+		WalkAimingFront,
+		ThrowUp,
+		ThrowDown,
+		ThrowFront,
+		Pick,
+		Hit,
+		Jump,
+		Fall
+	};
+
+	/** Direction or velocity in the XZ plane the game is played in */
+	struct FVec2
+	{
+		float X = 0.f;
+		float Z = 0.f;
+
+		FVec2() {}
+		FVec2(float InX, float InZ) : X(InX), Z(InZ) {}
+
+		float Dot(const FVec2& Other) const { return X * Other.X + Z * Other.Z; }
+		float SizeSquared() const { return X * X + Z * Z; }
+	};
+
+	struct FMovementBlock
+	{
+		EMovementBlockReason Reason = EMovementBlockReason::Aim;
+		bool bTimed = false;
+		float Time = 0.f;
+	};
+
+	struct FCharacterTuning
+	{
+		/** Throw animation time until the stone leaves the hand, also blocks movement */
+		float ThrowTimer = 0.5f;
+		float PickBlockTime = 0.6f;
+		/** Aim above / below this angle from the facing direction uses the up / down animations */
+		float AimSectorDegrees = 30.f;
+		int32_t InitialAmmo = 5;
+	};
+
+	/** Everything the rules own, a plain value that can be copied, hashed or stored in a rollback ring */
+	struct FCharacterState
+	{
+		static const int32_t MaxMovementBlocks = (int32_t)EMovementBlockReason::Count;
+
+		FVec2 AimDirection;
+		FVec2 ThrowDirection;
+		float ThrowTimerCurrent = 0.f;
+		int32_t Ammo = 5;
+		int32_t NumMovementBlocks = 0;
+		FMovementBlock MovementBlocks[MaxMovementBlocks];
+		EAnimationState AnimationState = EAnimationState::Idle;
+		bool bIsAiming = false;
+		bool bThrowing = false;
+		bool bIsReversing = false;
+		bool bFacingRight = true;
+	};
+
+	/** What the rules need to know about the body of the character for one call */
+	struct FCharacterContext
+	{
+		FVec2 Velocity;
+		/** Facing vector of the body, used for the aim sectors */
+		FVec2 Forward = FVec2(1.f, 0.f);
+		bool bFalling = false;
+		/** Whether something (controller or rollback input) decides where the character faces */
+		bool bControlsFacing = true;
+		/** AimDirection was refreshed for this update, stale aim does not turn the character */
+		bool bAimValid = true;
+		/** Whether a released throw can produce a stone, ammo is kept otherwise */
+		bool bCanLaunchStone = true;
+	};
+
+	namespace CharacterEvents
+	{
+		enum Type : uint32_t
+		{
+			StopMovement = 1 << 0,
+			/** The stone leaves the hand along ThrowDirection */
+			LaunchStone = 1 << 1,
+			AttachStone = 1 << 2,
+			DetachStone = 1 << 3,
+			/** AnimationState changed, pick a new flipbook */
+			AnimationChanged = 1 << 4,
+			/** Continue the new flipbook from the playback position of the old one */
+			SameFrame = 1 << 5,
+			PlayForward = 1 << 6,
+			PlayReverse = 1 << 7,
+			/** Restart the current flipbook without a state change */
+			RestartFlipbook = 1 << 8,
+			FacingChanged = 1 << 9,
+			Jump = 1 << 10
+		};
+	}
+
+	/** Side effects of one call, applied by whoever hosts the rules */
+	struct FCharacterEvents
+	{
+		uint32_t Flags = 0;
+		/** One bit per EMovementBlockReason */
+		uint8_t BlocksAdded = 0;
+		uint8_t BlocksRemoved = 0;
+
+		bool Has(CharacterEvents::Type Event) const { return (Flags & Event) != 0; }
+		void Add(CharacterEvents::Type Event) { Flags |= Event; }
+		void Reset() { *this = FCharacterEvents(); }
+	};
+
+	/**
+	 * Movement blocks, ammo, aim sectors, throw timing and animation state selection of the player
+	 * character. Stateless, every function works on a state value and reports its side effects.
+	 */
+	class FCharacterRules
+	{
+	public:
+		static void Reset(FCharacterState& State, const FCharacterTuning& Tuning);
+
+		static bool CanMove(const FCharacterState& State);
+		static bool CanJump(const FCharacterState& State, const FCharacterContext& Context);
+		static bool CanPick(const FCharacterState& State, const FCharacterContext& Context);
+		static bool CanAim(const FCharacterState& State, const FCharacterContext& Context);
+		static bool CanThrow(const FCharacterState& State, const FCharacterContext& Context);
+
+		static void Jump(FCharacterState& State, const FCharacterContext& Context, const FCharacterTuning& Tuning, FCharacterEvents& Events);
+
+		/** A stone was found and removed from the world by the host */
+		static void PickStone(FCharacterState& State, const FCharacterContext& Context, const FCharacterTuning& Tuning, FCharacterEvents& Events);
+
+		static void Aim(FCharacterState& State, const FCharacterContext& Context);
+		static void StopAim(FCharacterState& State);
+
+		/** Starts the throw animation, the stone is launched ThrowTimer later from Update */
+		static bool Throw(FCharacterState& State, const FCharacterContext& Context, const FCharacterTuning& Tuning, const FVec2& Direction, FCharacterEvents& Events);
+
+		static void AddMovementBlock(FCharacterState& State, const FMovementBlock& Block, FCharacterEvents& Events);
+		static void RemoveMovementBlock(FCharacterState& State, EMovementBlockReason Reason, FCharacterEvents& Events);
+		static void UpdateMovementBlocks(FCharacterState& State, float DeltaTime, FCharacterEvents& Events);
+
+		/** Per step logic: aim validity, throw timer, facing and animation state */
+		static void Update(FCharacterState& State, const FCharacterContext& Context, const FCharacterTuning& Tuning, float DeltaTime, FCharacterEvents& Events);
+
+		static void SetAnimationState(FCharacterState& State, const FCharacterContext& Context, const FCharacterTuning& Tuning, ESimpleAnimationState NewState, FCharacterEvents& Events);
+
+		/** The current flipbook played to its end */
+		static void FinishAnimation(FCharacterState& State, const FCharacterContext& Context, const FCharacterTuning& Tuning, FCharacterEvents& Events);
+
+	private:
+		static void UpdateAnimationState(FCharacterState& State, const FCharacterContext& Context, const FCharacterTuning& Tuning, FCharacterEvents& Events);
+		static void ReleaseThrow(FCharacterState& State, const FCharacterContext& Context, FCharacterEvents& Events);
+		static void SetFacing(FCharacterState& State, bool bRight, FCharacterEvents& Events);
+		/** 1 above the aim sector, -1 below it, 0 inside */
+		static int32_t GetAimSector(const FCharacterState& State, const FCharacterContext& Context, const FCharacterTuning& Tuning);
+	};
+
+	/** Held buttons of one step, presses and releases come from comparing with the previous step */
+	struct FHeadlessInput
+	{
+		float MoveAxis = 0.f;
+		FVec2 Aim = FVec2(1.f, 0.f);
+		bool bJump = false;
+		bool bAim = false;
+		bool bPick = false;
+	};
+
+	/**
+	 * The rules with the capsule reduced to a point over a flat floor at Z 0, for simulations that do not
+	 * need a world. Movement follows the character movement defaults closely enough for balance runs,
+	 * every pick attempt finds a stone.
+	 */
+	struct FHeadlessCharacter
+	{
+		FCharacterState State;
+		FVec2 Location;
+		FVec2 Velocity;
+		FHeadlessInput PreviousInput;
+		int32_t StonesThrown = 0;
+
+		float MaxWalkSpeed = 600.f;
+		float JumpZVelocity = 1000.f;
+		float Gravity = -1960.f;
+
+		void Step(const FCharacterTuning& Tuning, const FHeadlessInput& Input, float DeltaTime);
+	};
+}
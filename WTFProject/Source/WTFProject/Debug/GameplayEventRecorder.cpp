@@ -0,0 +1,174 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GameplayEventRecorder.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Paths.h"
+#include "Misc/DateTime.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/IConsoleManager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Async/Async.h"
+
+DEFINE_LOG_CATEGORY_STATIC(GameplayEvents, Log, All);
+
+static_assert((FGameplayEventRecorder::EventCapacity & (FGameplayEventRecorder::EventCapacity - 1)) == 0, "EventCapacity must be a power of two");
+static_assert(sizeof(FGameplayEventRecord) == 24, "FGameplayEventRecord is written to disk as is");
+
+static TAutoConsoleVariable<float> CVarHitchThresholdMs(
+	TEXT("wtf.HitchThresholdMs"),
+	100.f,
+	TEXT("Frames longer than this (in ms) dump the gameplay event ring to Saved/Hitches. 0 disables."));
+
+static TAutoConsoleVariable<float> CVarHitchDumpCooldown(
+	TEXT("wtf.HitchDumpCooldown"),
+	10.f,
+	TEXT("Minimum number of seconds between two hitch dumps."));
+
+static FAutoConsoleCommand CmdDumpGameplayEvents(
+	TEXT("wtf.DumpGameplayEvents"),
+	TEXT("Writes the gameplay event ring and frame time history to Saved/Hitches."),
+	FConsoleCommandDelegate::CreateLambda([]() { FGameplayEventRecorder::Dump(TEXT("Manual")); }));
+
+namespace
+{
+	struct FDumpHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		double SecondsPerCycle;
+		uint64 DumpCycles;
+		uint32 EventCount;
+		uint32 FrameCount;
+		char Reason[32];
+	};
+
+	const uint32 DumpMagic = 0x45465457; // "WTFE"
+	const uint32 DumpVersion = 1;
+}
+
+FGameplayEventRecord FGameplayEventRecorder::Events[FGameplayEventRecorder::EventCapacity];
+volatile int32 FGameplayEventRecorder::WriteIndex = 0;
+float FGameplayEventRecorder::FrameTimes[FGameplayEventRecorder::FrameCapacity];
+uint32 FGameplayEventRecorder::FrameIndex = 0;
+double FGameplayEventRecorder::LastFrameTime = 0.0;
+double FGameplayEventRecorder::LastDumpTime = 0.0;
+FDelegateHandle FGameplayEventRecorder::EndFrameHandle;
+FDelegateHandle FGameplayEventRecorder::SystemErrorHandle;
+
+void FGameplayEventRecorder::Startup()
+{
+	FMemory::Memzero(Events, sizeof(Events));
+	FMemory::Memzero(FrameTimes, sizeof(FrameTimes));
+	LastFrameTime = FPlatformTime::Seconds();
+
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&FGameplayEventRecorder::OnEndFrame);
+	SystemErrorHandle = FCoreDelegates::OnHandleSystemError.AddStatic(&FGameplayEventRecorder::OnSystemError);
+}
+
+void FGameplayEventRecorder::Shutdown()
+{
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	FCoreDelegates::OnHandleSystemError.Remove(SystemErrorHandle);
+}
+
+void FGameplayEventRecorder::OnEndFrame()
+{
+	const double Now = FPlatformTime::Seconds();
+	const float FrameMs = (float)((Now - LastFrameTime) * 1000.0);
+	LastFrameTime = Now;
+
+	FrameTimes[FrameIndex % FrameCapacity] = FrameMs;
+	FrameIndex++;
+
+	const float Threshold = CVarHitchThresholdMs.GetValueOnGameThread();
+	if (Threshold > 0.f && FrameMs > Threshold && Now - LastDumpTime > CVarHitchDumpCooldown.GetValueOnGameThread())
+	{
+		LastDumpTime = Now;
+		DumpAsync(TEXT("Hitch"), FrameMs);
+	}
+}
+
+void FGameplayEventRecorder::OnSystemError()
+{
+	Dump(TEXT("Crash"));
+}
+
+FString FGameplayEventRecorder::Dump(const TCHAR* Reason)
+{
+	TArray<uint8> Data;
+	Snapshot(Reason, Data);
+	const FString FileName = MakeDumpFileName(Reason);
+	return WriteDump(FileName, Data) ? FileName : FString();
+}
+
+void FGameplayEventRecorder::DumpAsync(const TCHAR* Reason, float FrameMs)
+{
+	TArray<uint8> Data;
+	Snapshot(Reason, Data);
+	const FString FileName = MakeDumpFileName(Reason);
+
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [FileName, Data = MoveTemp(Data), FrameMs]()
+	{
+		if (WriteDump(FileName, Data))
+		{
+			UE_LOG(GameplayEvents, Warning, TEXT("Hitch of %.1fms, gameplay events written to %s"), FrameMs, *FileName);
+		}
+		else
+		{
+			UE_LOG(GameplayEvents, Warning, TEXT("Hitch of %.1fms, writing %s failed"), FrameMs, *FileName);
+		}
+	});
+}
+
+FString FGameplayEventRecorder::MakeDumpFileName(const TCHAR* Reason)
+{
+	return FPaths::ProjectSavedDir() / TEXT("Hitches") / FString::Printf(TEXT("%s_%s.wtfe"), Reason, *FDateTime::Now().ToString());
+}
+
+void FGameplayEventRecorder::Snapshot(const TCHAR* Reason, TArray<uint8>& OutData)
+{
+	// Oldest entry first. Writers are not stopped, an entry being overwritten right now may come out torn.
+	const uint32 Written = (uint32)WriteIndex;
+	const uint32 EventCount = FMath::Min(Written, EventCapacity);
+	const uint32 FrameCount = FMath::Min(FrameIndex, FrameCapacity);
+
+	FDumpHeader Header;
+	FMemory::Memzero(Header);
+	Header.Magic = DumpMagic;
+	Header.Version = DumpVersion;
+	Header.SecondsPerCycle = FPlatformTime::GetSecondsPerCycle64();
+	Header.DumpCycles = FPlatformTime::Cycles64();
+	Header.EventCount = EventCount;
+	Header.FrameCount = FrameCount;
+	FCStringAnsi::Strncpy(Header.Reason, TCHAR_TO_ANSI(Reason), sizeof(Header.Reason));
+
+	OutData.SetNumUninitialized(sizeof(Header) + EventCount * sizeof(FGameplayEventRecord) + FrameCount * sizeof(float));
+	uint8* Out = OutData.GetData();
+	FMemory::Memcpy(Out, &Header, sizeof(Header));
+	Out += sizeof(Header);
+
+	// At most two contiguous runs each, the ring may wrap
+	const uint32 FirstEvent = (Written - EventCount) & (EventCapacity - 1);
+	const uint32 EventsToEnd = FMath::Min(EventCount, EventCapacity - FirstEvent);
+	FMemory::Memcpy(Out, &Events[FirstEvent], EventsToEnd * sizeof(FGameplayEventRecord));
+	FMemory::Memcpy(Out + EventsToEnd * sizeof(FGameplayEventRecord), &Events[0], (EventCount - EventsToEnd) * sizeof(FGameplayEventRecord));
+	Out += EventCount * sizeof(FGameplayEventRecord);
+
+	const uint32 FirstFrame = (FrameIndex - FrameCount) % FrameCapacity;
+	const uint32 FramesToEnd = FMath::Min(FrameCount, FrameCapacity - FirstFrame);
+	FMemory::Memcpy(Out, &FrameTimes[FirstFrame], FramesToEnd * sizeof(float));
+	FMemory::Memcpy(Out + FramesToEnd * sizeof(float), &FrameTimes[0], (FrameCount - FramesToEnd) * sizeof(float));
+}
+
+bool FGameplayEventRecorder::WriteDump(const FString& FileName, const TArray<uint8>& Data)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FileName));
+	IFileHandle* File = PlatformFile.OpenWrite(*FileName);
+	if (!File)
+		return false;
+
+	const bool bWritten = File->Write(Data.GetData(), Data.Num());
+	delete File;
+	return bWritten;
+}
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/PlatformAtomics.h"
+#include "UObject/UObjectBase.h"
+
+enum class EGameplayEventType : uint8
+{
+	GE_Throw,
+	GE_Spawn,
+	GE_Pick,
+	GE_Hit,
+	GE_AnimationState,
+	GE_MovementBlockAdded,
+	GE_MovementBlockRemoved
+};
+
+/** One entry of the event ring, kept POD and 24 bytes so a record is a handful of stores */
+struct FGameplayEventRecord
+{
+	uint64 Cycles;
+	uint32 ObjectId;
+	uint8 Type;
+	uint8 Arg;
+	uint16 Pad;
+	float X;
+	float Z;
+};
+
+/**
+ * Always-on flight recorder for gameplay events. Writers from any thread claim a slot with one
+ * atomic increment and overwrite the oldest entry; nothing is locked or allocated. When a frame takes
+ * longer than wtf.HitchThresholdMs, or the process crashes, the ring and the recent frame times are
+ * written to Saved/Hitches/*.wtfe. Hitch dumps copy the ring on the game thread and write it on a
+ * background thread, so the dump does not hitch the next frame as well.
+ *
+ * A record costs tens of nanoseconds, wtf.StoneStorm.Benchmark logs the measured figure.
+ */
+class WTFPROJECT_API FGameplayEventRecorder
+{
+public:
+	static const uint32 EventCapacity = 4096;
+	static const uint32 FrameCapacity = 512;
+
+	static FORCEINLINE void Record(EGameplayEventType Type, const UObjectBase* Object, uint8 Arg, const FVector& Location)
+	{
+		const uint32 Slot = (uint32)(FPlatformAtomics::InterlockedIncrement(&WriteIndex) - 1) & (EventCapacity - 1);
+		FGameplayEventRecord& Event = Events[Slot];
+		Event.Cycles = FPlatformTime::Cycles64();
+		Event.ObjectId = Object ? Object->GetUniqueID() : 0;
+		Event.Type = (uint8)Type;
+		Event.Arg = Arg;
+		Event.Pad = 0;
+		Event.X = Location.X;
+		Event.Z = Location.Z;
+	}
+
+	static void Startup();
+	static void Shutdown();
+
+	/** Writes the current ring to disk, returns the file name or an empty string on failure */
+	static FString Dump(const TCHAR* Reason);
+
+	/** Copies the current ring and writes it on a background thread */
+	static void DumpAsync(const TCHAR* Reason, float FrameMs);
+
+private:
+	/** Header, events oldest first and frame times, as written to the file */
+	static void Snapshot(const TCHAR* Reason, TArray<uint8>& OutData);
+	static FString MakeDumpFileName(const TCHAR* Reason);
+	static bool WriteDump(const FString& FileName, const TArray<uint8>& Data);
+
+	static void OnEndFrame();
+	static void OnSystemError();
+
+	static FGameplayEventRecord Events[EventCapacity];
+	static volatile int32 WriteIndex;
+
+	static float FrameTimes[FrameCapacity];
+	static uint32 FrameIndex;
+	static double LastFrameTime;
+	static double LastDumpTime;
+
+	static FDelegateHandle EndFrameHandle;
+	static FDelegateHandle SystemErrorHandle;
+};
@@ -0,0 +1,318 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "InputLatencyTracker.h"
+#include "WTFProject.h"
+#include "RenderingThread.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Framework/Application/IInputProcessor.h"
+#include "GameFramework/InputSettings.h"
+#include "Rendering/SlateRenderer.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Paths.h"
+#include "Misc/DateTime.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeLock.h"
+
+DEFINE_LOG_CATEGORY_STATIC(InputLatency, Log, All);
+
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Input To Game Thread (ms)"), STAT_InputLatencyGame, STATGROUP_WTFProject);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Input To Render Thread (ms)"), STAT_InputLatencyRender, STATGROUP_WTFProject);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Input To Present (ms)"), STAT_InputLatencyPresent, STATGROUP_WTFProject);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Input To Present Avg (ms)"), STAT_InputLatencyPresentAvg, STATGROUP_WTFProject);
+
+static TAutoConsoleVariable<int32> CVarInputLatencyCsv(
+	TEXT("wtf.InputLatency.Csv"),
+	0,
+	TEXT("1 writes every completed input latency sample to Saved/Profiling/InputLatency_*.csv."));
+
+static FAutoConsoleCommand CmdInputLatencyReport(
+	TEXT("wtf.InputLatency.Report"),
+	TEXT("Prints the input to present latency histogram."),
+	FConsoleCommandDelegate::CreateStatic(&FInputLatencyTracker::PrintReport));
+
+/** Stamps key and mouse button events when Slate receives them, before the input component dispatches them later in the frame */
+class FInputLatencyPreProcessor : public IInputProcessor
+{
+public:
+	/** Last press or release of each key */
+	TMap<FKey, double> EventTimes;
+
+	virtual void Tick(const float DeltaTime, FSlateApplication& SlateApp, TSharedRef<ICursor> Cursor) override
+	{
+	}
+
+	virtual bool HandleKeyDownEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent) override
+	{
+		// A held key repeats, the press was the input
+		if (!InKeyEvent.IsRepeat())
+			EventTimes.Add(InKeyEvent.GetKey(), FPlatformTime::Seconds());
+		return false;
+	}
+
+	virtual bool HandleKeyUpEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent) override
+	{
+		EventTimes.Add(InKeyEvent.GetKey(), FPlatformTime::Seconds());
+		return false;
+	}
+
+	virtual bool HandleMouseButtonDownEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent) override
+	{
+		EventTimes.Add(MouseEvent.GetEffectingButton(), FPlatformTime::Seconds());
+		return false;
+	}
+
+	virtual bool HandleMouseButtonUpEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent) override
+	{
+		EventTimes.Add(MouseEvent.GetEffectingButton(), FPlatformTime::Seconds());
+		return false;
+	}
+};
+
+const float FInputLatencyTracker::BucketMs = 2.f;
+const double FInputLatencyTracker::SampleTimeout = 2.0;
+FCriticalSection FInputLatencyTracker::SamplesLock;
+FInputLatencyTracker::FSample FInputLatencyTracker::Samples[FInputLatencyTracker::MaxPendingSamples];
+uint32 FInputLatencyTracker::NextSampleId = 1;
+TArray<uint32> FInputLatencyTracker::AwaitingPresent;
+TQueue<uint32, EQueueMode::Mpsc> FInputLatencyTracker::Completed;
+uint32 FInputLatencyTracker::Histogram[FInputLatencyTracker::NumBuckets + 1];
+uint32 FInputLatencyTracker::NumCompleted = 0;
+uint32 FInputLatencyTracker::NumTimedOut = 0;
+uint32 FInputLatencyTracker::NumCancelled = 0;
+double FInputLatencyTracker::TotalGameMs = 0.0;
+double FInputLatencyTracker::TotalRenderMs = 0.0;
+double FInputLatencyTracker::TotalPresentMs = 0.0;
+FArchive* FInputLatencyTracker::CsvFile = nullptr;
+bool FInputLatencyTracker::bPresentCallbackRegistered = false;
+double FInputLatencyTracker::FrameStartTime = 0.0;
+TSharedPtr<FInputLatencyPreProcessor> FInputLatencyTracker::InputProcessor;
+FDelegateHandle FInputLatencyTracker::EndFrameHandle;
+FDelegateHandle FInputLatencyTracker::PresentHandle;
+
+void FInputLatencyTracker::Startup()
+{
+	FMemory::Memzero(Histogram, sizeof(Histogram));
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&FInputLatencyTracker::OnEndFrame);
+}
+
+void FInputLatencyTracker::Shutdown()
+{
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	if (bPresentCallbackRegistered && FSlateApplication::IsInitialized() && FSlateApplication::Get().GetRenderer())
+	{
+		FSlateApplication::Get().GetRenderer()->OnBackBufferReadyToPresent().Remove(PresentHandle);
+		FSlateApplication::Get().UnregisterInputPreProcessor(InputProcessor);
+	}
+	bPresentCallbackRegistered = false;
+	InputProcessor.Reset();
+
+	delete CsvFile;
+	CsvFile = nullptr;
+}
+
+void FInputLatencyTracker::RegisterSlateCallbacks()
+{
+	if (bPresentCallbackRegistered || !FSlateApplication::IsInitialized() || !FSlateApplication::Get().GetRenderer())
+		return;
+
+	PresentHandle = FSlateApplication::Get().GetRenderer()->OnBackBufferReadyToPresent().AddStatic(&FInputLatencyTracker::OnBackBufferReadyToPresent);
+	InputProcessor = MakeShareable(new FInputLatencyPreProcessor());
+	FSlateApplication::Get().RegisterInputPreProcessor(InputProcessor);
+	bPresentCallbackRegistered = true;
+}
+
+uint32 FInputLatencyTracker::BeginSample(const TCHAR* Action, FName InputAction)
+{
+	check(IsInGameThread());
+	RegisterSlateCallbacks();
+	if (!bPresentCallbackRegistered)
+		return InvalidSample;
+
+	FScopeLock Lock(&SamplesLock);
+	const uint32 Id = NextSampleId++;
+	if (NextSampleId == InvalidSample)
+		NextSampleId++;
+
+	FSample& Sample = Samples[Id % MaxPendingSamples];
+	Sample = FSample();
+	Sample.Id = Id;
+	Sample.Action = Action;
+	Sample.InputComponentTime = FPlatformTime::Seconds();
+	Sample.InputTime = Sample.InputComponentTime;
+
+	// The event of a key bound to the action, an event from before this frame belongs to an earlier press
+	for (const FInputActionKeyMapping& Mapping : GetDefault<UInputSettings>()->ActionMappings)
+	{
+		const double* EventTime = Mapping.ActionName == InputAction ? InputProcessor->EventTimes.Find(Mapping.Key) : nullptr;
+		if (EventTime && *EventTime >= FrameStartTime && *EventTime < Sample.InputTime)
+			Sample.InputTime = *EventTime;
+	}
+	return Id;
+}
+
+void FInputLatencyTracker::CancelSample(uint32 SampleId)
+{
+	if (SampleId == InvalidSample)
+		return;
+
+	FScopeLock Lock(&SamplesLock);
+	FSample& Sample = Samples[SampleId % MaxPendingSamples];
+	if (Sample.Id == SampleId && Sample.GameThreadTime == 0.0)
+	{
+		Sample.Id = InvalidSample;
+		NumCancelled++;
+	}
+}
+
+void FInputLatencyTracker::MarkGameThread(uint32 SampleId)
+{
+	if (SampleId == InvalidSample)
+		return;
+
+	{
+		FScopeLock Lock(&SamplesLock);
+		FSample& Sample = Samples[SampleId % MaxPendingSamples];
+		if (Sample.Id != SampleId)
+			return;
+
+		Sample.GameThreadTime = FPlatformTime::Seconds();
+	}
+	ENQUEUE_RENDER_COMMAND(MarkInputLatency)(
+		[SampleId](FRHICommandListImmediate& RHICmdList)
+		{
+			FInputLatencyTracker::MarkRenderThread(SampleId);
+		});
+}
+
+void FInputLatencyTracker::MarkRenderThread(uint32 SampleId)
+{
+	FScopeLock Lock(&SamplesLock);
+	FSample& Sample = Samples[SampleId % MaxPendingSamples];
+	if (Sample.Id != SampleId)
+		return;
+
+	Sample.RenderThreadTime = FPlatformTime::Seconds();
+	AwaitingPresent.Add(SampleId);
+}
+
+void FInputLatencyTracker::OnBackBufferReadyToPresent(SWindow& Window, const FTexture2DRHIRef& BackBuffer)
+{
+	if (AwaitingPresent.Num() == 0)
+		return;
+
+	const double Now = FPlatformTime::Seconds();
+	FScopeLock Lock(&SamplesLock);
+	for (uint32 SampleId : AwaitingPresent)
+	{
+		FSample& Sample = Samples[SampleId % MaxPendingSamples];
+		if (Sample.Id == SampleId)
+		{
+			Sample.PresentTime = Now;
+			Completed.Enqueue(SampleId);
+		}
+	}
+	AwaitingPresent.Reset();
+}
+
+void FInputLatencyTracker::OnEndFrame()
+{
+	// Registered ahead of the first sample so its input event is stamped too
+	RegisterSlateCallbacks();
+	FrameStartTime = FPlatformTime::Seconds();
+
+	TArray<FSample, TInlineAllocator<8>> Finished;
+	{
+		FScopeLock Lock(&SamplesLock);
+		uint32 SampleId;
+		while (Completed.Dequeue(SampleId))
+		{
+			FSample& Sample = Samples[SampleId % MaxPendingSamples];
+			if (Sample.Id == SampleId)
+			{
+				Finished.Add(Sample);
+				Sample.Id = InvalidSample;
+			}
+		}
+
+		// Dropping slow samples would bias the histogram towards fast frames, so they are counted
+		const double Now = FPlatformTime::Seconds();
+		for (FSample& Sample : Samples)
+		{
+			if (Sample.Id != InvalidSample && Sample.GameThreadTime == 0.0 && Now - Sample.InputComponentTime > SampleTimeout)
+			{
+				Sample.Id = InvalidSample;
+				NumTimedOut++;
+			}
+		}
+	}
+
+	for (const FSample& Sample : Finished)
+		Complete(Sample);
+}
+
+void FInputLatencyTracker::Complete(const FSample& Sample)
+{
+	const float GameMs = (float)((Sample.GameThreadTime - Sample.InputTime) * 1000.0);
+	const float RenderMs = (float)((Sample.RenderThreadTime - Sample.InputTime) * 1000.0);
+	const float PresentMs = (float)((Sample.PresentTime - Sample.InputTime) * 1000.0);
+
+	NumCompleted++;
+	TotalGameMs += GameMs;
+	TotalRenderMs += RenderMs;
+	TotalPresentMs += PresentMs;
+	Histogram[FMath::Clamp(FMath::FloorToInt(PresentMs / BucketMs), 0, NumBuckets)]++;
+
+	SET_FLOAT_STAT(STAT_InputLatencyGame, GameMs);
+	SET_FLOAT_STAT(STAT_InputLatencyRender, RenderMs);
+	SET_FLOAT_STAT(STAT_InputLatencyPresent, PresentMs);
+	SET_FLOAT_STAT(STAT_InputLatencyPresentAvg, (float)(TotalPresentMs / NumCompleted));
+
+	if (CVarInputLatencyCsv.GetValueOnGameThread() != 0)
+		WriteCsv(Sample);
+}
+
+void FInputLatencyTracker::WriteCsv(const FSample& Sample)
+{
+	if (!CsvFile)
+	{
+		const FString FileName = FPaths::ProfilingDir() / FString::Printf(TEXT("InputLatency_%s.csv"), *FDateTime::Now().ToString());
+		CsvFile = IFileManager::Get().CreateFileWriter(*FileName);
+		if (!CsvFile)
+			return;
+
+		const ANSICHAR* Header = "Action,InputComponentMs,GameThreadMs,RenderThreadMs,PresentMs\n";
+		CsvFile->Serialize((void*)Header, FCStringAnsi::Strlen(Header));
+	}
+
+	const FString Line = FString::Printf(TEXT("%s,%.3f,%.3f,%.3f,%.3f\n"), Sample.Action,
+		(Sample.InputComponentTime - Sample.InputTime) * 1000.0,
+		(Sample.GameThreadTime - Sample.InputTime) * 1000.0,
+		(Sample.RenderThreadTime - Sample.InputTime) * 1000.0,
+		(Sample.PresentTime - Sample.InputTime) * 1000.0);
+	FTCHARToUTF8 Utf8Line(*Line);
+	CsvFile->Serialize((void*)Utf8Line.Get(), Utf8Line.Length());
+	CsvFile->Flush();
+}
+
+void FInputLatencyTracker::PrintReport()
+{
+	if (NumCompleted == 0 && NumTimedOut == 0)
+	{
+		UE_LOG(InputLatency, Display, TEXT("No input latency samples yet"));
+		return;
+	}
+
+	UE_LOG(InputLatency, Display, TEXT("%u samples, avg game thread %.2fms, render thread %.2fms, present %.2fms"),
+		NumCompleted, TotalGameMs / FMath::Max(NumCompleted, 1u), TotalRenderMs / FMath::Max(NumCompleted, 1u), TotalPresentMs / FMath::Max(NumCompleted, 1u));
+	UE_LOG(InputLatency, Display, TEXT("%u timed out after %.1fs without a visible change, %u rejected or replaced by a newer input"), NumTimedOut, SampleTimeout, NumCancelled);
+
+	for (int32 Bucket = 0; Bucket <= NumBuckets; Bucket++)
+	{
+		if (Histogram[Bucket] == 0)
+			continue;
+
+		const FString Range = Bucket < NumBuckets ? FString::Printf(TEXT("%3.0f-%3.0fms"), Bucket * BucketMs, (Bucket + 1) * BucketMs) : FString::Printf(TEXT(">= %.0fms"), Bucket * BucketMs);
+		UE_LOG(InputLatency, Display, TEXT("  %s %6u %s"), *Range, Histogram[Bucket], *FString::ChrN(FMath::Min<uint32>(Histogram[Bucket] * 60 / NumCompleted + 1, 60), TEXT('#')));
+	}
+}
@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/CriticalSection.h"
+#include "RHI.h"
+
+class SWindow;
+class FInputLatencyPreProcessor;
+
+/**
+ * Measures how long an input takes to become visible. A sample starts when an action binding fires
+ * (timestamped back to when Slate received the key or button event of that action, through an input
+ * preprocessor that sees every event before it is routed), travels with the gameplay state change it
+ * causes, and is stamped again when the new flipbook is set on the game thread, when the render thread
+ * picks up that frame, and when the back buffer is handed to present. A sample whose change never shows
+ * up within SampleTimeout is counted as timed out rather than dropped.
+ *
+ * Results go to the WTFProject stat group, a histogram printed by wtf.InputLatency.Report and, with
+ * wtf.InputLatency.Csv 1, one line per sample in Saved/Profiling/InputLatency_*.csv.
+ */
+class WTFPROJECT_API FInputLatencyTracker
+{
+public:
+	static const uint32 InvalidSample = 0;
+
+	static void Startup();
+	static void Shutdown();
+
+	/** Call from the handler of InputAction, returns the id to carry along until the visible change */
+	static uint32 BeginSample(const TCHAR* Action, FName InputAction);
+
+	/** The state change of the sample reached the sprite, the rest is stamped by the renderer */
+	static void MarkGameThread(uint32 SampleId);
+
+	/** The input was rejected or replaced by a newer one before it led to a visible change */
+	static void CancelSample(uint32 SampleId);
+
+	/** Samples still waiting for their game thread change after this long are counted as timed out */
+	static const double SampleTimeout;
+
+	static void PrintReport();
+
+private:
+	struct FSample
+	{
+		uint32 Id = InvalidSample;
+		const TCHAR* Action = nullptr;
+		double InputTime = 0.0;
+		double InputComponentTime = 0.0;
+		double GameThreadTime = 0.0;
+		double RenderThreadTime = 0.0;
+		double PresentTime = 0.0;
+	};
+
+	static const uint32 MaxPendingSamples = 64;
+	static const int32 NumBuckets = 50;
+	static const float BucketMs;
+
+	static void MarkRenderThread(uint32 SampleId);
+	static void OnBackBufferReadyToPresent(SWindow& Window, const FTexture2DRHIRef& BackBuffer);
+	static void OnEndFrame();
+	/** Hooks into Slate, which may not exist yet when the module starts and never does on a dedicated server */
+	static void RegisterSlateCallbacks();
+	static void Complete(const FSample& Sample);
+	static void WriteCsv(const FSample& Sample);
+
+	/** Samples are stamped from the game and render threads */
+	static FCriticalSection SamplesLock;
+	static FSample Samples[MaxPendingSamples];
+	static uint32 NextSampleId;
+
+	/** Render thread only */
+	static TArray<uint32> AwaitingPresent;
+	static TQueue<uint32, EQueueMode::Mpsc> Completed;
+
+	static uint32 Histogram[NumBuckets + 1];
+	static uint32 NumCompleted;
+	static uint32 NumTimedOut;
+	static uint32 NumCancelled;
+	static double TotalGameMs;
+	static double TotalRenderMs;
+	static double TotalPresentMs;
+
+	static FArchive* CsvFile;
+	static bool bPresentCallbackRegistered;
+
+	/** Game thread only, key and button events newer than this were received in the current frame */
+	static double FrameStartTime;
+	static TSharedPtr<FInputLatencyPreProcessor> InputProcessor;
+
+	static FDelegateHandle EndFrameHandle;
+	static FDelegateHandle PresentHandle;
+};
@@ -0,0 +1,157 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LoadOrderRecorder.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/UObjectGlobals.h"
+#include "UObject/Package.h"
+#include "Engine/World.h"
+#include "HAL/PlatformMisc.h"
+#include "CoreGlobals.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LoadOrder, Log, All);
+
+namespace
+{
+	double MapLoadStartTime = 0.0;
+	FString LoadingMapName;
+	bool bFirstMapLoaded = false;
+}
+
+FLoadOrderRecorder* FLoadOrderRecorder::Instance = nullptr;
+FDelegateHandle FLoadOrderRecorder::EngineInitHandle;
+FDelegateHandle FLoadOrderRecorder::PreLoadMapHandle;
+FDelegateHandle FLoadOrderRecorder::PostLoadMapHandle;
+FDelegateHandle FLoadOrderRecorder::EndFrameHandle;
+const TCHAR* FLoadOrderRecorder::BootPackagesFileName = TEXT("BootPackages.txt");
+
+void FLoadOrderRecorder::Startup()
+{
+	EngineInitHandle = FCoreDelegates::OnFEngineLoopInitComplete.AddStatic(&FLoadOrderRecorder::OnEngineInitComplete);
+	PreLoadMapHandle = FCoreUObjectDelegates::PreLoadMap.AddStatic(&FLoadOrderRecorder::OnPreLoadMap);
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddStatic(&FLoadOrderRecorder::OnPostLoadMap);
+
+	// The game module loads before the default map, so everything the map pulls in is seen
+	float Seconds = 0.f;
+	const bool bRecord = FParse::Param(FCommandLine::Get(), TEXT("RecordLoadOrder")) || FParse::Value(FCommandLine::Get(), TEXT("RecordLoadOrder="), Seconds);
+	if (!bRecord)
+		return;
+
+	Instance = new FLoadOrderRecorder();
+	if (Seconds > 0.f)
+		Instance->RecordSeconds = Seconds;
+	GUObjectArray.AddUObjectCreateListener(Instance);
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&FLoadOrderRecorder::OnEndFrame);
+	UE_LOG(LoadOrder, Display, TEXT("Recording package load order for %.0fs after the first map"), Instance->RecordSeconds);
+}
+
+void FLoadOrderRecorder::Shutdown()
+{
+	FCoreDelegates::OnFEngineLoopInitComplete.Remove(EngineInitHandle);
+	FCoreUObjectDelegates::PreLoadMap.Remove(PreLoadMapHandle);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+	if (!Instance)
+		return;
+
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	GUObjectArray.RemoveUObjectCreateListener(Instance);
+	delete Instance;
+	Instance = nullptr;
+}
+
+void FLoadOrderRecorder::NotifyUObjectCreated(const UObjectBase* Object, int32 Index)
+{
+	if (Object->GetClass() != UPackage::StaticClass())
+		return;
+
+	FScopeLock ScopeLock(&Lock);
+	Packages.Add(Object->GetFName());
+}
+
+void FLoadOrderRecorder::OnEngineInitComplete()
+{
+	UE_LOG(LoadOrder, Display, TEXT("Engine init took %.3fs"), FPlatformTime::Seconds() - GStartTime);
+}
+
+void FLoadOrderRecorder::OnPreLoadMap(const FString& MapName)
+{
+	MapLoadStartTime = FPlatformTime::Seconds();
+	LoadingMapName = MapName;
+}
+
+void FLoadOrderRecorder::OnPostLoadMap(UWorld* World)
+{
+	const double Now = FPlatformTime::Seconds();
+	if (MapLoadStartTime > 0.0)
+		UE_LOG(LoadOrder, Display, TEXT("Map %s loaded in %.3fs"), *LoadingMapName, Now - MapLoadStartTime);
+	MapLoadStartTime = 0.0;
+
+	if (bFirstMapLoaded)
+		return;
+
+	bFirstMapLoaded = true;
+	UE_LOG(LoadOrder, Display, TEXT("First map up %.3fs after process start"), Now - GStartTime);
+	if (Instance)
+		Instance->StopTime = Now + Instance->RecordSeconds;
+}
+
+void FLoadOrderRecorder::OnEndFrame()
+{
+	if (!Instance || Instance->StopTime == 0.0 || FPlatformTime::Seconds() < Instance->StopTime)
+		return;
+
+	Instance->StopTime = 0.0;
+	GUObjectArray.RemoveUObjectCreateListener(Instance);
+	Instance->Write();
+	FPlatformMisc::RequestExit(false);
+}
+
+bool FLoadOrderRecorder::Write() const
+{
+	TArray<FName> Order;
+	{
+		FScopeLock ScopeLock(&Lock);
+		Order = Packages;
+	}
+
+	// Only cooked content goes to the pak, a package recreated after an unload keeps its first slot
+	TSet<FName> Seen;
+	FString OpenOrder;
+	FString BootPackages;
+	int32 NumFiles = 0;
+	int32 NumBoot = 0;
+	for (const FName& PackageName : Order)
+	{
+		const FString Name = PackageName.ToString();
+		bool bAlreadySeen = false;
+		Seen.Add(PackageName, &bAlreadySeen);
+		if (bAlreadySeen || !Name.StartsWith(TEXT("/Game/")))
+			continue;
+
+		FString FileName;
+		if (!FPackageName::DoesPackageExist(Name, nullptr, &FileName))
+			continue;
+
+		BootPackages += Name + LINE_TERMINATOR;
+		NumBoot++;
+
+		// DoesPackageExist gives the uncooked path relative to the engine binaries, UnrealPak matches
+		// the staged path, which is the same for every machine: ../../../<Project>/Content/...
+		const FString StagedName = FString::Printf(TEXT("../../../%s/Content/%s"), FApp::GetProjectName(), *Name.RightChop(FCString::Strlen(TEXT("/Game/"))));
+		for (const FString& Extension : { FPaths::GetExtension(FileName, true), FString(TEXT(".uexp")), FString(TEXT(".ubulk")) })
+			OpenOrder += FString::Printf(TEXT("\"%s%s\" %d") LINE_TERMINATOR, *StagedName, *Extension, ++NumFiles);
+	}
+
+	const FString Dir = FPaths::ProjectSavedDir() / TEXT("LoadOrder");
+	const bool bWritten = FFileHelper::SaveStringToFile(OpenOrder, *(Dir / TEXT("GameOpenOrder.log")))
+		&& FFileHelper::SaveStringToFile(BootPackages, *(Dir / BootPackagesFileName));
+	UE_LOG(LoadOrder, Display, TEXT("%d of %d recorded packages are boot content, %s to %s"), NumBoot, Order.Num(),
+		bWritten ? TEXT("written") : TEXT("failed to write"), *Dir);
+	return bWritten;
+}
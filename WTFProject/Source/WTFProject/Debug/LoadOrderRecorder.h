@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/UObjectArray.h"
+
+class UWorld;
+
+/**
+ * Logs how long the engine takes to boot and each map to load. With -RecordLoadOrder[=Seconds] it also
+ * records every /Game package in the order it is created, keeps playing for Seconds (default 20) after
+ * the first map is up, then writes Saved/LoadOrder/GameOpenOrder.log and BootPackages.txt and exits.
+ *
+ * GameOpenOrder.log goes to Build/LinuxNoEditor/FileOpenOrder/ so UnrealPak lays the files out in that
+ * order, BootPackages.txt goes to Build/LoadOrder/ where UAssetManagerWTF reads the boot chunk from.
+ */
+class WTFPROJECT_API FLoadOrderRecorder : public FUObjectArray::FUObjectCreateListener
+{
+public:
+	static void Startup();
+	static void Shutdown();
+
+	static bool IsRecording() { return Instance != nullptr; }
+
+	virtual void NotifyUObjectCreated(const class UObjectBase* Object, int32 Index) override;
+
+	/** Name of the list of boot packages, relative to Saved/LoadOrder and Build/LoadOrder */
+	static const TCHAR* BootPackagesFileName;
+
+private:
+	static void OnEngineInitComplete();
+	static void OnPreLoadMap(const FString& MapName);
+	static void OnPostLoadMap(UWorld* World);
+	static void OnEndFrame();
+
+	/** Writes the recorded order, returns false if nothing could be written */
+	bool Write() const;
+
+	static FLoadOrderRecorder* Instance;
+
+	static FDelegateHandle EngineInitHandle;
+	static FDelegateHandle PreLoadMapHandle;
+	static FDelegateHandle PostLoadMapHandle;
+	static FDelegateHandle EndFrameHandle;
+
+	/** Packages are created on the async loading thread too */
+	mutable FCriticalSection Lock;
+	TArray<FName> Packages;
+	double StopTime = 0.0;
+	float RecordSeconds = 20.f;
+};
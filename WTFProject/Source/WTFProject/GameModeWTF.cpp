@@ -1,7 +1,124 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "GameModeWTF.h"
+#include "GameStateWTF.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+#include "Net/RollbackManager.h"
+#include "AI/StoneBotController.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
 
+DEFINE_LOG_CATEGORY_STATIC(Rounds, Log, All);
 
+namespace
+{
+	/** Survives the seamless travel, the game mode of the next map is a new object */
+	double RoundChangeStartTime = 0.0;
+}
 
+AGameModeWTF::AGameModeWTF()
+{
+	GameStateClass = AGameStateWTF::StaticClass();
+	bUseSeamlessTravel = true;
+	// Warmup ends on a timer, not when players are ready
+	bDelayedStart = true;
+}
 
+void AGameModeWTF::StartPlay()
+{
+	Super::StartPlay();
+
+	// 1v1 peer-to-peer duel, see ARollbackManager
+	if (ARollbackManager::IsRollbackRequested() && GetNetMode() == NM_Standalone)
+		GetWorld()->SpawnActor<ARollbackManager>();
+
+	// -bots=N adds stone throwing opponents around the player start
+	int32 NumBots = 0;
+	if (FParse::Value(FCommandLine::Get(), TEXT("bots="), NumBots) && NumBots > 0 && GetNetMode() != NM_Client)
+	{
+		AActor* PlayerStart = FindPlayerStart(nullptr);
+		AStoneBotController::SpawnBots(GetWorld(), DefaultPawnClass, PlayerStart ? PlayerStart->GetActorLocation() : FVector::ZeroVector, NumBots);
+	}
+}
+
+bool AGameModeWTF::HasRounds() const
+{
+	// The rollback duel starts right away and never travels, neither does a standalone game
+	return GetNetMode() != NM_Standalone && !ARollbackManager::IsRollbackRequested();
+}
+
+FString AGameModeWTF::GetNextMap() const
+{
+	const FString CurrentMap = UWorld::RemovePIEPrefix(GetWorld()->GetOutermost()->GetName());
+	if (MapRotation.Num() == 0)
+		return CurrentMap;
+
+	// Maps outside the rotation continue with its first map
+	const int32 CurrentIndex = MapRotation.IndexOfByKey(CurrentMap);
+	return MapRotation[(CurrentIndex + 1) % MapRotation.Num()];
+}
+
+void AGameModeWTF::HandleMatchIsWaitingToStart()
+{
+	Super::HandleMatchIsWaitingToStart();
+
+	if (RoundChangeStartTime > 0.0)
+	{
+		const double Seconds = FPlatformTime::Seconds() - RoundChangeStartTime;
+		UE_LOG(Rounds, Display, TEXT("Round change to %s took %.3fs on the server"), *GetWorld()->GetMapName(), Seconds);
+		if (Seconds > RoundChangeBudget)
+			UE_LOG(Rounds, Warning, TEXT("Round change is over its %.1fs budget"), RoundChangeBudget);
+		if (NumTravellingPlayers == 0)
+			RoundChangeStartTime = 0.0;
+	}
+
+	if (!HasRounds())
+	{
+		StartMatch();
+		return;
+	}
+	GetWorldTimerManager().SetTimer(RoundTimerHandle, this, &AGameModeWTF::StartMatch, FMath::Max(WarmupTime, 0.01f));
+}
+
+void AGameModeWTF::HandleMatchHasStarted()
+{
+	Super::HandleMatchHasStarted();
+
+	if (!HasRounds())
+		return;
+
+	GetWorldTimerManager().SetTimer(RoundTimerHandle, this, &AGameModeWTF::EndMatch, FMath::Max(RoundTime, 0.01f));
+	if (AGameStateWTF* WTFGameState = GetGameState<AGameStateWTF>())
+		WTFGameState->SetNextMap(GetNextMap());
+	UE_LOG(Rounds, Display, TEXT("Round started, next map %s"), *GetNextMap());
+}
+
+void AGameModeWTF::HandleMatchHasEnded()
+{
+	Super::HandleMatchHasEnded();
+	GetWorldTimerManager().SetTimer(RoundTimerHandle, this, &AGameModeWTF::TravelToNextMap, FMath::Max(RoundEndTime, 0.01f));
+}
+
+void AGameModeWTF::TravelToNextMap()
+{
+	const FString NextMap = GetNextMap();
+	RoundChangeStartTime = FPlatformTime::Seconds();
+	UE_LOG(Rounds, Display, TEXT("Round over, travelling to %s"), *NextMap);
+	GetWorld()->ServerTravel(NextMap, false);
+}
+
+void AGameModeWTF::HandleSeamlessTravelPlayer(AController*& C)
+{
+	Super::HandleSeamlessTravelPlayer(C);
+
+	// Clients stay connected, the round change is over for everyone once the last of them arrived
+	if (NumTravellingPlayers == 0 && RoundChangeStartTime > 0.0)
+	{
+		const double Seconds = FPlatformTime::Seconds() - RoundChangeStartTime;
+		UE_LOG(Rounds, Display, TEXT("All players back %.3fs after the round ended"), Seconds);
+		if (Seconds > RoundChangeBudget)
+			UE_LOG(Rounds, Warning, TEXT("Round change is over its %.1fs budget"), RoundChangeBudget);
+		RoundChangeStartTime = 0.0;
+	}
+}
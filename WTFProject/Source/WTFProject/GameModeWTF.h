@@ -7,14 +7,54 @@
 #include "GameModeWTF.generated.h"
 
 /**
- * 
+ * Runs rounds on top of the match states of AGameMode: WaitingToStart is the warmup, InProgress the
+ * round and WaitingPostMatch the round end, after which the server seamlessly travels to the next map
+ * of MapRotation. The next map is announced through AGameStateWTF as soon as a round starts, so the
+ * server and every client load it in the background while the round is played.
+ *
+ * Rounds only run on listen and dedicated servers. A standalone game, the rollback duel included,
+ * starts its match right away and stays on its map.
  */
-UCLASS()
+UCLASS(Config = Game)
 class WTFPROJECT_API AGameModeWTF : public AGameMode
 {
 	GENERATED_BODY()
-	
-	
-	
-	
+
+public:
+	AGameModeWTF();
+
+	virtual void StartPlay() override;
+	virtual void HandleSeamlessTravelPlayer(AController*& C) override;
+
+	/** Map after the current one in MapRotation, the current one when the rotation is empty */
+	FString GetNextMap() const;
+
+	/** Whether matches end and travel to the next map */
+	bool HasRounds() const;
+
+protected:
+	virtual void HandleMatchIsWaitingToStart() override;
+	virtual void HandleMatchHasStarted() override;
+	virtual void HandleMatchHasEnded() override;
+
+	void TravelToNextMap();
+
+	UPROPERTY(Config, EditAnywhere, Category = "Rounds")
+	TArray<FString> MapRotation;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Rounds")
+	float WarmupTime = 5.f;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Rounds")
+	float RoundTime = 120.f;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Rounds")
+	float RoundEndTime = 5.f;
+
+	/** Round changes slower than this are logged as warnings */
+	UPROPERTY(Config, EditAnywhere, Category = "Rounds")
+	float RoundChangeBudget = 1.f;
+
+private:
+	FTimerHandle RoundTimerHandle;
 };
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GameStateWTF.h"
+#include "GameplayTuning.h"
+#include "Engine/World.h"
+#include "Net/UnrealNetwork.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectGlobals.h"
+
+DEFINE_LOG_CATEGORY_STATIC(MapPreload, Log, All);
+
+UPackage* AGameStateWTF::PreloadedMap = nullptr;
+double AGameStateWTF::PreloadStartTime = 0.0;
+
+void AGameStateWTF::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME(AGameStateWTF, NextMap);
+	DOREPLIFETIME(AGameStateWTF, Tuning);
+}
+
+void AGameStateWTF::BeginPlay()
+{
+	Super::BeginPlay();
+	// The preloaded map is the one being played now, or it was not travelled to
+	ReleasePreloadedMap();
+
+	if (HasAuthority())
+		ReplicateTuning();
+}
+
+void FReplicatedTuning::Set(const FGameplayTuning& From)
+{
+	ThrowTimer = From.Character.ThrowTimer;
+	PickBlockTime = From.Character.PickBlockTime;
+	AimSectorDegrees = From.Character.AimSectorDegrees;
+	InitialAmmo = From.Character.InitialAmmo;
+	GravityScale = From.GravityScale;
+	AirControl = From.AirControl;
+	JumpZVelocity = From.JumpZVelocity;
+	GroundFriction = From.GroundFriction;
+	MaxWalkSpeed = From.MaxWalkSpeed;
+	MaxFlySpeed = From.MaxFlySpeed;
+	Version = From.Version;
+}
+
+void FReplicatedTuning::ApplyTo(FGameplayTuning& To) const
+{
+	To.Character.ThrowTimer = ThrowTimer;
+	To.Character.PickBlockTime = PickBlockTime;
+	To.Character.AimSectorDegrees = AimSectorDegrees;
+	To.Character.InitialAmmo = InitialAmmo;
+	To.GravityScale = GravityScale;
+	To.AirControl = AirControl;
+	To.JumpZVelocity = JumpZVelocity;
+	To.GroundFriction = GroundFriction;
+	To.MaxWalkSpeed = MaxWalkSpeed;
+	To.MaxFlySpeed = MaxFlySpeed;
+}
+
+void AGameStateWTF::ReplicateTuning()
+{
+	Tuning.Set(FGameplayTuning::Get());
+}
+
+void AGameStateWTF::OnRep_Tuning()
+{
+	// A listen server keeps its own snapshot, it is the one being replicated
+	if (HasAuthority() || Tuning.Version == 0)
+		return;
+
+	FGameplayTuning Received = FGameplayTuning::Get();
+	Tuning.ApplyTo(Received);
+	FGameplayTuning::Publish(Received);
+}
+
+void AGameStateWTF::SetNextMap(const FString& Map)
+{
+	NextMap = Map;
+	PreloadMap(Map);
+}
+
+void AGameStateWTF::OnRep_NextMap()
+{
+	PreloadMap(NextMap);
+}
+
+void AGameStateWTF::PreloadMap(const FString& Map)
+{
+	// Travelling to the map being played reloads it, there is nothing to load ahead
+	if (Map.IsEmpty() || Map == GetWorld()->GetOutermost()->GetName())
+		return;
+
+	ReleasePreloadedMap();
+	PreloadStartTime = FPlatformTime::Seconds();
+	LoadPackageAsync(Map, FLoadPackageAsyncDelegate::CreateStatic(&AGameStateWTF::OnMapPreloaded));
+}
+
+void AGameStateWTF::OnMapPreloaded(const FName& PackageName, UPackage* LoadedPackage, EAsyncLoadingResult::Type Result)
+{
+	if (Result != EAsyncLoadingResult::Succeeded || !LoadedPackage)
+	{
+		UE_LOG(MapPreload, Warning, TEXT("Preloading %s failed, the round change will load it"), *PackageName.ToString());
+		return;
+	}
+
+	// The old world is collected before the travel handler loads the new one, keep this alive through it
+	ReleasePreloadedMap();
+	LoadedPackage->AddToRoot();
+	PreloadedMap = LoadedPackage;
+	UE_LOG(MapPreload, Display, TEXT("Preloaded %s in %.3fs"), *PackageName.ToString(), FPlatformTime::Seconds() - PreloadStartTime);
+}
+
+void AGameStateWTF::ReleasePreloadedMap()
+{
+	if (!PreloadedMap)
+		return;
+
+	PreloadedMap->RemoveFromRoot();
+	PreloadedMap = nullptr;
+}
@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameState.h"
+#include "GameStateWTF.generated.h"
+
+class UPackage;
+struct FGameplayTuning;
+
+/** FGameplayTuning as it is sent to clients */
+USTRUCT()
+struct FReplicatedTuning
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	float ThrowTimer = 0.f;
+
+	UPROPERTY()
+	float PickBlockTime = 0.f;
+
+	UPROPERTY()
+	float AimSectorDegrees = 0.f;
+
+	UPROPERTY()
+	int32 InitialAmmo = 0;
+
+	UPROPERTY()
+	float GravityScale = 0.f;
+
+	UPROPERTY()
+	float AirControl = 0.f;
+
+	UPROPERTY()
+	float JumpZVelocity = 0.f;
+
+	UPROPERTY()
+	float GroundFriction = 0.f;
+
+	UPROPERTY()
+	float MaxWalkSpeed = 0.f;
+
+	UPROPERTY()
+	float MaxFlySpeed = 0.f;
+
+	/** The server's FGameplayTuning::Version, 0 until the server has set it */
+	UPROPERTY()
+	uint32 Version = 0;
+
+	void Set(const FGameplayTuning& Tuning);
+	void ApplyTo(FGameplayTuning& Tuning) const;
+};
+
+/**
+ * Carries the map of the next round to the clients so they can load it while the current round is
+ * played. The loaded package is kept rooted through the seamless travel, where the travel handler finds
+ * it in memory, and released once the new world has started.
+ *
+ * Also carries the server's gameplay tuning, clients publish it as their own FGameplayTuning.
+ */
+UCLASS()
+class WTFPROJECT_API AGameStateWTF : public AGameState
+{
+	GENERATED_BODY()
+
+public:
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/** Server only, starts the preload here and on every client */
+	void SetNextMap(const FString& Map);
+
+	static void ReleasePreloadedMap();
+
+	/** Server only, sends the current FGameplayTuning to the clients */
+	void ReplicateTuning();
+
+protected:
+	virtual void BeginPlay() override;
+
+	UFUNCTION()
+	void OnRep_NextMap();
+
+	UPROPERTY(ReplicatedUsing = OnRep_NextMap)
+	FString NextMap;
+
+	UFUNCTION()
+	void OnRep_Tuning();
+
+	UPROPERTY(ReplicatedUsing = OnRep_Tuning)
+	FReplicatedTuning Tuning;
+
+private:
+	void PreloadMap(const FString& Map);
+	static void OnMapPreloaded(const FName& PackageName, UPackage* LoadedPackage, EAsyncLoadingResult::Type Result);
+
+	static UPackage* PreloadedMap;
+	static double PreloadStartTime;
+};
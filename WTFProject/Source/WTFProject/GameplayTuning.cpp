@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GameplayTuning.h"
+#include "GameStateWTF.h"
+#include "Net/RollbackManager.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/Paths.h"
+#include "Misc/Parse.h"
+#include "Misc/CommandLine.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(GameplayTuning, Log, All);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdTuningReload(
+	TEXT("wtf.Tuning.Reload"),
+	TEXT("wtf.Tuning.Reload [File]: reads the gameplay tuning again from File, by default Config/Tuning.ini or -TuningFile=. Run it on the server, clients receive the new tuning through the game state. Characters pick it up on their next tick."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		// Peers of a rollback session must run the same rules, a local change would desync them
+		if (World && TActorIterator<ARollbackManager>(World))
+		{
+			UE_LOG(GameplayTuning, Warning, TEXT("Not reloading during a rollback session"));
+			return;
+		}
+		// Client movement has to predict with the server's numbers
+		if (World && World->GetNetMode() == NM_Client)
+		{
+			UE_LOG(GameplayTuning, Warning, TEXT("Not reloading on a client, the server's tuning is replicated"));
+			return;
+		}
+		if (!FGameplayTuning::Load(Args.Num() > 0 ? Args[0] : FGameplayTuning::GetDefaultFileName()))
+			return;
+
+		if (AGameStateWTF* GameState = World ? World->GetGameState<AGameStateWTF>() : nullptr)
+			GameState->ReplicateTuning();
+	}));
+
+FGameplayTuning FGameplayTuning::Defaults;
+FGameplayTuning* FGameplayTuning::Current = &FGameplayTuning::Defaults;
+TArray<TUniquePtr<FGameplayTuning>> FGameplayTuning::Snapshots;
+
+namespace
+{
+	void ReadValue(const FConfigFile& File, const TCHAR* Section, const TCHAR* Key, float& Value)
+	{
+		FString String;
+		if (File.GetString(Section, Key, String))
+			Value = FCString::Atof(*String);
+	}
+
+	void ReadValue(const FConfigFile& File, const TCHAR* Section, const TCHAR* Key, int32& Value)
+	{
+		FString String;
+		if (File.GetString(Section, Key, String))
+			Value = FCString::Atoi(*String);
+	}
+}
+
+void FGameplayTuning::Startup()
+{
+	Load(GetDefaultFileName());
+}
+
+void FGameplayTuning::Shutdown()
+{
+	Current = &Defaults;
+	Snapshots.Empty();
+}
+
+FString FGameplayTuning::GetDefaultFileName()
+{
+	FString FileName;
+	if (FParse::Value(FCommandLine::Get(), TEXT("TuningFile="), FileName))
+		return FileName;
+	return FPaths::ProjectConfigDir() / TEXT("Tuning.ini");
+}
+
+bool FGameplayTuning::Load(const FString& FileName)
+{
+	// Read straight from disk, GConfig would return what was cached at startup
+	if (!FPaths::FileExists(FileName))
+	{
+		UE_LOG(GameplayTuning, Warning, TEXT("%s not found, keeping tuning version %u"), *FileName, Current->Version);
+		return false;
+	}
+
+	FConfigFile File;
+	File.Read(FileName);
+
+	FGameplayTuning Loaded = *Current;
+	ReadValue(File, TEXT("Character"), TEXT("ThrowTimer"), Loaded.Character.ThrowTimer);
+	ReadValue(File, TEXT("Character"), TEXT("PickBlockTime"), Loaded.Character.PickBlockTime);
+	ReadValue(File, TEXT("Character"), TEXT("AimSectorDegrees"), Loaded.Character.AimSectorDegrees);
+	ReadValue(File, TEXT("Character"), TEXT("InitialAmmo"), Loaded.Character.InitialAmmo);
+	ReadValue(File, TEXT("Movement"), TEXT("GravityScale"), Loaded.GravityScale);
+	ReadValue(File, TEXT("Movement"), TEXT("AirControl"), Loaded.AirControl);
+	ReadValue(File, TEXT("Movement"), TEXT("JumpZVelocity"), Loaded.JumpZVelocity);
+	ReadValue(File, TEXT("Movement"), TEXT("GroundFriction"), Loaded.GroundFriction);
+	ReadValue(File, TEXT("Movement"), TEXT("MaxWalkSpeed"), Loaded.MaxWalkSpeed);
+	ReadValue(File, TEXT("Movement"), TEXT("MaxFlySpeed"), Loaded.MaxFlySpeed);
+	Publish(Loaded);
+
+	UE_LOG(GameplayTuning, Display, TEXT("Tuning version %u loaded from %s"), Current->Version, *FileName);
+	return true;
+}
+
+void FGameplayTuning::Publish(const FGameplayTuning& Tuning)
+{
+	TUniquePtr<FGameplayTuning> Snapshot = MakeUnique<FGameplayTuning>(Tuning);
+	Snapshot->Version = Current->Version + 1;
+
+	// Fully built before it becomes visible, readers see either the old snapshot or this one
+	FGameplayTuning* Published = Snapshot.Get();
+	Snapshots.Add(MoveTemp(Snapshot));
+	FPlatformAtomics::InterlockedExchangePtr((void**)&Current, Published);
+}
@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/CharacterCore.h"
+
+/**
+ * Gameplay numbers read from Config/Tuning.ini instead of being compiled in. Every load builds a new
+ * immutable snapshot and publishes it with one pointer swap, so a reload never changes values under a
+ * reader. Hot paths keep a pointer to the snapshot they were set up from and compare it with Get()
+ * to notice a reload; a read is a pointer load and a field access.
+ *
+ * Reload on a running game or server with wtf.Tuning.Reload [File]. The server owns the tuning,
+ * AGameStateWTF replicates it and clients publish what they receive, so movement prediction keeps
+ * using the same numbers as the server. Clients do not reload on their own.
+ */
+struct WTFPROJECT_API FGameplayTuning
+{
+	/** Passed as is to WTFCore::FCharacterRules */
+	WTFCore::FCharacterTuning Character;
+
+	/** Character movement */
+	float GravityScale = 2.f;
+	float AirControl = 0.8f;
+	float JumpZVelocity = 1000.f;
+	float GroundFriction = 3.f;
+	float MaxWalkSpeed = 600.f;
+	float MaxFlySpeed = 600.f;
+
+	/** 0 for the built-in defaults, counts up with every load */
+	uint32 Version = 0;
+
+	/** The current snapshot, stays valid until the module shuts down */
+	static FORCEINLINE const FGameplayTuning& Get() { return *Current; }
+
+	static void Startup();
+	static void Shutdown();
+
+	/** Reads FileName over a copy of the current snapshot and publishes it, keys missing from the file keep their value */
+	static bool Load(const FString& FileName);
+
+	/** Publishes a copy of Tuning as the next version */
+	static void Publish(const FGameplayTuning& Tuning);
+
+	static FString GetDefaultFileName();
+
+private:
+	static FGameplayTuning* Current;
+	static FGameplayTuning Defaults;
+
+	/** Replaced snapshots are never freed while running, a reader may still hold one and a new one must not reuse its address */
+	static TArray<TUniquePtr<FGameplayTuning>> Snapshots;
+};
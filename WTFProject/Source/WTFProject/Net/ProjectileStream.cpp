@@ -0,0 +1,282 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ProjectileStream.h"
+#include "WTFProjectCharacter.h"
+#include "Objects/Stone.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+#include "Engine/NetDriver.h"
+#include "Engine/NetConnection.h"
+#include "EngineUtils.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/UnrealNetwork.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(ProjectileStream, Log, All);
+
+static TAutoConsoleVariable<int32> CVarProjectileStream(
+	TEXT("wtf.ProjectileNet.Stream"),
+	0,
+	TEXT("1 replicates server throws through AProjectileStream events, 0 spawns one replicated AStone per throw."));
+
+#if WITH_PROJECTILE_NET_STATS
+static FAutoConsoleCommandWithWorld CmdProjectileNetReport(
+	TEXT("wtf.ProjectileNet.Report"),
+	TEXT("Logs the payload the server sent per thrown stone under both schemes since the last reset."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&FProjectileNetStats::Report));
+
+static FAutoConsoleCommand CmdProjectileNetReset(
+	TEXT("wtf.ProjectileNet.Reset"),
+	TEXT("Clears the thrown stone bandwidth counters."),
+	FConsoleCommandDelegate::CreateStatic(&FProjectileNetStats::Reset));
+#endif
+
+int64 FProjectileNetStats::StreamBits = 0;
+int64 FProjectileNetStats::ActorBits = 0;
+int32 FProjectileNetStats::StreamThrows = 0;
+int32 FProjectileNetStats::ActorThrows = 0;
+
+void FProjectileNetStats::Reset()
+{
+	StreamBits = 0;
+	ActorBits = 0;
+	StreamThrows = 0;
+	ActorThrows = 0;
+}
+
+void FProjectileNetStats::Report(UWorld* World)
+{
+	UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+	const int32 NumClients = NetDriver ? NetDriver->ClientConnections.Num() : 0;
+	if (NumClients == 0)
+	{
+		UE_LOG(ProjectileStream, Display, TEXT("No client connections, run this on the server"));
+		return;
+	}
+
+	// Bits are summed over connections, so divide by the clients connected now
+	auto PerThrow = [NumClients](int64 Bits, int32 Throws) { return Throws > 0 ? (double)Bits / 8.0 / Throws / NumClients : 0.0; };
+	UE_LOG(ProjectileStream, Display, TEXT("Actor per stone: %d throws, %.1f bytes per throw per client"), ActorThrows, PerThrow(ActorBits, ActorThrows));
+	UE_LOG(ProjectileStream, Display, TEXT("Event stream:    %d throws, %.1f bytes per throw per client"), StreamThrows, PerThrow(StreamBits, StreamThrows));
+}
+
+uint16 FStreamedProjectile::QuantizeDirection(const FVector& Direction)
+{
+	const float Turns = FMath::Atan2(Direction.Z, Direction.X) / (2.f * PI);
+	return (uint16)(FMath::RoundToInt(Turns * 65536.f) & 0xFFFF);
+}
+
+FVector FStreamedProjectile::DequantizeDirection(uint16 InAngle)
+{
+	const float Radians = InAngle * (2.f * PI / 65536.f);
+	return FVector(FMath::Cos(Radians), 0.f, FMath::Sin(Radians));
+}
+
+void FStreamedProjectile::PostReplicatedAdd(const FStreamedProjectileList& InArraySerializer)
+{
+	if (InArraySerializer.Stream)
+		InArraySerializer.Stream->SpawnLocalStone(*this);
+}
+
+void FStreamedProjectile::PostReplicatedChange(const FStreamedProjectileList& InArraySerializer)
+{
+	if (InArraySerializer.Stream)
+		InArraySerializer.Stream->CorrectLocalStone(*this);
+}
+
+void FStreamedProjectile::PreReplicatedRemove(const FStreamedProjectileList& InArraySerializer)
+{
+	if (Stone.IsValid())
+		Stone->Destroy();
+}
+
+bool FStreamedProjectileList::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+{
+#if WITH_PROJECTILE_NET_STATS
+	const int64 StartBits = DeltaParms.Writer ? DeltaParms.Writer->GetNumBits() : 0;
+	const bool bResult = FFastArraySerializer::FastArrayDeltaSerialize<FStreamedProjectile, FStreamedProjectileList>(Items, DeltaParms, *this);
+	if (DeltaParms.Writer)
+		FProjectileNetStats::StreamBits += DeltaParms.Writer->GetNumBits() - StartBits;
+	return bResult;
+#else
+	return FFastArraySerializer::FastArrayDeltaSerialize<FStreamedProjectile, FStreamedProjectileList>(Items, DeltaParms, *this);
+#endif
+}
+
+AProjectileStream::AProjectileStream()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	bReplicates = true;
+	bAlwaysRelevant = true;
+	Projectiles.Stream = this;
+}
+
+void AProjectileStream::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME(AProjectileStream, Projectiles);
+}
+
+bool AProjectileStream::IsEnabled(UWorld* World)
+{
+	if (!World || CVarProjectileStream.GetValueOnGameThread() == 0)
+		return false;
+
+	const ENetMode NetMode = World->GetNetMode();
+	return NetMode == NM_ListenServer || NetMode == NM_DedicatedServer;
+}
+
+AProjectileStream* AProjectileStream::Get(UWorld* World)
+{
+	for (TActorIterator<AProjectileStream> It(World); It; ++It)
+		return *It;
+
+	FActorSpawnParameters Params;
+	Params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return World->SpawnActor<AProjectileStream>(AProjectileStream::StaticClass(), FTransform::Identity, Params);
+}
+
+void AProjectileStream::BeginPlay()
+{
+	Super::BeginPlay();
+	if (HasAuthority())
+		GetWorldTimerManager().SetTimer(ExpireTimer, this, &AProjectileStream::ExpireProjectiles, 1.f, true);
+}
+
+void AProjectileStream::ExpireProjectiles()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	const float ServerNow = GameState ? GameState->GetServerWorldTimeSeconds() : Now;
+
+	TArray<TWeakObjectPtr<AStone>, TInlineAllocator<16>> Expired;
+	for (const FStreamedProjectile& Projectile : Projectiles.Items)
+	{
+		const bool bRested = Projectile.bImpacted && Now - Projectile.ImpactTime > RestedLifetime && Projectile.Stone.IsValid() && Projectile.Stone->IsResting();
+		if (bRested || ServerNow - Projectile.ServerTime > MaxLifetime)
+			Expired.Add(Projectile.Stone);
+	}
+
+	// The stone removes its event when it ends play, the removal then destroys the client stones
+	for (const TWeakObjectPtr<AStone>& Stone : Expired)
+	{
+		if (Stone.IsValid())
+			Stone->Destroy();
+	}
+}
+
+void AProjectileStream::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Destroying a server stone removes its event, so iterate a detached list
+	TArray<FStreamedProjectile> Items = MoveTemp(Projectiles.Items);
+	for (FStreamedProjectile& Projectile : Items)
+	{
+		if (Projectile.Stone.IsValid())
+			Projectile.Stone->Destroy();
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+AStone* AProjectileStream::SpawnStone(TSubclassOf<AStone> StoneClass, AWTFProjectCharacter* Thrower, const FVector& Location, const FVector& Direction)
+{
+	UWorld* World = GetWorld();
+	if (!StoneClass || !World)
+		return nullptr;
+
+	// Replication is switched off before BeginPlay, so no actor channel is ever opened for it
+	const FTransform Transform(Direction.Rotation(), Location);
+	AStone* Stone = World->SpawnActorDeferred<AStone>(StoneClass, Transform, nullptr, Thrower, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	if (!Stone)
+		return nullptr;
+
+	Stone->SetReplicates(false);
+	Stone->FinishSpawning(Transform);
+	Stone->Launch(Thrower, Location, Direction);
+	return Stone;
+}
+
+FStreamedProjectile* AProjectileStream::FindProjectile(int32 Id)
+{
+	return Projectiles.Items.FindByPredicate([Id](const FStreamedProjectile& Projectile) { return Projectile.ReplicationID == Id; });
+}
+
+void AProjectileStream::Throw(AWTFProjectCharacter* Thrower, TSubclassOf<AStone> StoneClass, const FVector& Location, const FVector& Direction)
+{
+	FStreamedProjectile Projectile;
+	Projectile.Origin = Location;
+	Projectile.Angle = FStreamedProjectile::QuantizeDirection(Direction);
+	Projectile.ServerTime = GetWorld()->GetGameState() ? GetWorld()->GetGameState()->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+	Projectile.Owner = Thrower;
+
+	// The server simulates the quantized direction too, so its stone flies the arc the clients see
+	AStone* Stone = SpawnStone(StoneClass, Thrower, Projectile.Origin, FStreamedProjectile::DequantizeDirection(Projectile.Angle));
+	if (!Stone)
+		return;
+
+	FStreamedProjectile& Added = Projectiles.Items[Projectiles.Items.Add(Projectile)];
+	Projectiles.MarkItemDirty(Added);
+	Added.Stone = Stone;
+	Stone->SetStreamed(this, Added.ReplicationID);
+#if WITH_PROJECTILE_NET_STATS
+	FProjectileNetStats::StreamThrows++;
+#endif
+}
+
+void AProjectileStream::OnStoneImpact(int32 Id, const FVector& Location)
+{
+	FStreamedProjectile* Projectile = FindProjectile(Id);
+	if (!Projectile || Projectile->bImpacted)
+		return;
+
+	Projectile->bImpacted = true;
+	Projectile->ImpactLocation = Location;
+	Projectile->ImpactTime = GetWorld()->GetTimeSeconds();
+	Projectiles.MarkItemDirty(*Projectile);
+}
+
+void AProjectileStream::OnStoneRemoved(int32 Id)
+{
+	const int32 Index = Projectiles.Items.IndexOfByPredicate([Id](const FStreamedProjectile& Projectile) { return Projectile.ReplicationID == Id; });
+	if (Index == INDEX_NONE)
+		return;
+
+	Projectiles.Items.RemoveAtSwap(Index);
+	Projectiles.MarkArrayDirty();
+}
+
+void AProjectileStream::SpawnLocalStone(FStreamedProjectile& Projectile)
+{
+	// The owner may not be mapped yet, PostReplicatedChange comes again once it is
+	if (Projectile.bSpawned || !Projectile.Owner)
+		return;
+
+	AStone* Stone = SpawnStone(Projectile.Owner->StoneClass, Projectile.Owner, Projectile.Origin, FStreamedProjectile::DequantizeDirection(Projectile.Angle));
+	if (!Stone)
+		return;
+
+	Projectile.Stone = Stone;
+	Projectile.bSpawned = true;
+	if (Projectile.bImpacted)
+	{
+		Stone->CorrectImpact(Projectile.ImpactLocation);
+		return;
+	}
+
+	// Events arrive half a round trip late, and much later for a client that just joined
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	const float Late = GameState ? GameState->GetServerWorldTimeSeconds() - Projectile.ServerTime : 0.f;
+	if (Late > 0.f)
+		Stone->FastForward(FMath::Min(Late, MaxFastForward));
+}
+
+void AProjectileStream::CorrectLocalStone(FStreamedProjectile& Projectile)
+{
+	if (!Projectile.bSpawned)
+	{
+		SpawnLocalStone(Projectile);
+		return;
+	}
+
+	if (Projectile.bImpacted && Projectile.Stone.IsValid())
+		Projectile.Stone->CorrectImpact(Projectile.ImpactLocation);
+}
@@ -0,0 +1,157 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WTFProject.h"
+#include "GameFramework/Actor.h"
+#include "Engine/NetSerialization.h"
+#include "ProjectileStream.generated.h"
+
+class AWTFProjectCharacter;
+class AStone;
+class AProjectileStream;
+
+/** Payload bits the server wrote for thrown stones under each scheme, summed over all client connections */
+struct WTFPROJECT_API FProjectileNetStats
+{
+	static int64 StreamBits;
+	static int64 ActorBits;
+	static int32 StreamThrows;
+	static int32 ActorThrows;
+
+	static void Reset();
+	static void Report(UWorld* World);
+};
+
+/** One server throw. Everything after the spawn is simulated by each client, only the impact is corrected. */
+USTRUCT()
+struct FStreamedProjectile : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector_NetQuantize Origin;
+
+	/** Throw direction in the X-Z plane, a full turn is 65536 */
+	UPROPERTY()
+	uint16 Angle = 0;
+
+	UPROPERTY()
+	float ServerTime = 0.f;
+
+	UPROPERTY()
+	AWTFProjectCharacter* Owner = nullptr;
+
+	UPROPERTY()
+	bool bImpacted = false;
+
+	/** Where the server stone hit, valid once bImpacted is set */
+	UPROPERTY()
+	FVector_NetQuantize ImpactLocation;
+
+	/** The local, non-replicated stone simulating this throw */
+	TWeakObjectPtr<AStone> Stone;
+
+	/** Set once the local stone was spawned, a stone picked on this client is not brought back */
+	bool bSpawned = false;
+
+	/** Server only, world time of the impact */
+	float ImpactTime = 0.f;
+
+	static uint16 QuantizeDirection(const FVector& Direction);
+	static FVector DequantizeDirection(uint16 Angle);
+
+	void PostReplicatedAdd(const struct FStreamedProjectileList& InArraySerializer);
+	void PostReplicatedChange(const struct FStreamedProjectileList& InArraySerializer);
+	void PreReplicatedRemove(const struct FStreamedProjectileList& InArraySerializer);
+};
+
+USTRUCT()
+struct FStreamedProjectileList : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FStreamedProjectile> Items;
+
+	AProjectileStream* Stream = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms);
+};
+
+template<>
+struct TStructOpsTypeTraits<FStreamedProjectileList> : public TStructOpsTypeTraitsBase2<FStreamedProjectileList>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/**
+ * Replicates server throws as a list of compact spawn events instead of one replicated AStone each.
+ * The server and every client spawn a local, non-replicated stone per event along the same quantized
+ * direction and simulate it themselves; the server only sends the impact location afterwards so a hit
+ * the client missed is corrected, and removes the event when the stone is picked.
+ *
+ * Stones left lying unpicked for RestedLifetime, or alive for MaxLifetime, are destroyed on the server
+ * and so removed everywhere, otherwise every stone ever thrown would stay in the list and be spawned
+ * again by each client that joins.
+ *
+ * Used on listen and dedicated servers while wtf.ProjectileNet.Stream is 1.
+ */
+UCLASS(NotBlueprintable)
+class WTFPROJECT_API AProjectileStream : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AProjectileStream();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	static bool IsEnabled(UWorld* World);
+
+	/** Spawns the stream on first use, server only */
+	static AProjectileStream* Get(UWorld* World);
+
+	void Throw(AWTFProjectCharacter* Thrower, TSubclassOf<AStone> StoneClass, const FVector& Location, const FVector& Direction);
+
+	/** Called by the server stone of the event */
+	void OnStoneImpact(int32 Id, const FVector& Location);
+	void OnStoneRemoved(int32 Id);
+
+	/** Client side of the replication callbacks */
+	void SpawnLocalStone(FStreamedProjectile& Projectile);
+	void CorrectLocalStone(FStreamedProjectile& Projectile);
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Late events are simulated forward by at most this many seconds before they show up */
+	UPROPERTY(EditAnywhere, Category = "Projectiles")
+	float MaxFastForward = 2.f;
+
+	/** Seconds a stone may lie on the ground after its impact before it is removed */
+	UPROPERTY(EditAnywhere, Category = "Projectiles")
+	float RestedLifetime = 30.f;
+
+	/** Seconds after the throw any stone is removed, for stones that never come to rest */
+	UPROPERTY(EditAnywhere, Category = "Projectiles")
+	float MaxLifetime = 120.f;
+
+private:
+	FStreamedProjectile* FindProjectile(int32 Id);
+
+	/** Server only, destroys the stones of events past their lifetime */
+	void ExpireProjectiles();
+
+	FTimerHandle ExpireTimer;
+
+	AStone* SpawnStone(TSubclassOf<AStone> StoneClass, AWTFProjectCharacter* Thrower, const FVector& Location, const FVector& Direction);
+
+	UPROPERTY(Replicated)
+	FStreamedProjectileList Projectiles;
+};
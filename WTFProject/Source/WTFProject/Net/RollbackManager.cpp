@@ -0,0 +1,355 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "RollbackManager.h"
+#include "WTFProject.h"
+#include "WTFProjectCharacter.h"
+#include "Objects/Stone.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/GameModeBase.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "Misc/CommandLine.h"
+
+DEFINE_LOG_CATEGORY_STATIC(Rollback, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("Rollback Resimulation"), STAT_RollbackResimulate, STATGROUP_WTFProject);
+DECLARE_CYCLE_STAT(TEXT("Rollback Frame"), STAT_RollbackFrame, STATGROUP_WTFProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Rollbacks"), STAT_Rollbacks, STATGROUP_WTFProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Resimulated Frames"), STAT_RollbackResimulatedFrames, STATGROUP_WTFProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Stalled Frames"), STAT_RollbackStalls, STATGROUP_WTFProject);
+
+namespace
+{
+	const uint32 RollbackPacketMagic = 0x57544652; // "WTFR"
+}
+
+ARollbackManager::ARollbackManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+	bReplicates = false;
+
+	SpawnLocations.Add(FVector(-600.f, 0.f, 300.f));
+	SpawnLocations.Add(FVector(600.f, 0.f, 300.f));
+}
+
+bool ARollbackManager::IsRollbackRequested()
+{
+	return FParse::Param(FCommandLine::Get(), TEXT("rollback"));
+}
+
+void ARollbackManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	const TCHAR* CommandLine = FCommandLine::Get();
+	int32 LocalPort = 7000;
+	FString PeerAddress = TEXT("127.0.0.1:7001");
+	float LatencyMs = 0.f;
+	float JitterMs = 0.f;
+	float LossRate = 0.f;
+	FParse::Value(CommandLine, TEXT("rollbackplayer="), LocalPlayer);
+	FParse::Value(CommandLine, TEXT("rollbackport="), LocalPort);
+	FParse::Value(CommandLine, TEXT("rollbackpeer="), PeerAddress);
+	FParse::Value(CommandLine, TEXT("rollbacklatency="), LatencyMs);
+	FParse::Value(CommandLine, TEXT("rollbackjitter="), JitterMs);
+	FParse::Value(CommandLine, TEXT("rollbackloss="), LossRate);
+	LocalPlayer = FMath::Clamp(LocalPlayer, 0, 1);
+	RemotePlayer = 1 - LocalPlayer;
+
+	if (!Transport.Init(LocalPort, PeerAddress, LatencyMs, JitterMs, LossRate))
+	{
+		SetActorTickEnabled(false);
+		return;
+	}
+
+	for (int32 i = 0; i < BufferSize; i++)
+	{
+		RemoteInputFrames[i] = INDEX_NONE;
+		RemoteConfirmed[i] = false;
+	}
+
+	SetupCharacters();
+	SetupStonePool();
+}
+
+void ARollbackManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Transport.Shutdown();
+	Super::EndPlay(EndPlayReason);
+}
+
+void ARollbackManager::SetupCharacters()
+{
+	UWorld* World = GetWorld();
+	APlayerController* PlController = World->GetFirstPlayerController();
+	AGameModeBase* GameMode = World->GetAuthGameMode();
+	UClass* CharacterClass = GameMode ? GameMode->DefaultPawnClass : nullptr;
+	if (!CharacterClass || !CharacterClass->IsChildOf(AWTFProjectCharacter::StaticClass()))
+		CharacterClass = AWTFProjectCharacter::StaticClass();
+
+	// Both peers spawn player 0 and player 1 at the same places, only the possessed one differs
+	if (PlController && PlController->GetPawn())
+		PlController->GetPawn()->Destroy();
+
+	Characters.SetNum(FRollbackFrameState::MaxPlayers);
+	for (int32 i = 0; i < FRollbackFrameState::MaxPlayers; i++)
+	{
+		FActorSpawnParameters Params;
+		Params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		const FVector Location = SpawnLocations.IsValidIndex(i) ? SpawnLocations[i] : FVector::ZeroVector;
+		Characters[i] = World->SpawnActor<AWTFProjectCharacter>(CharacterClass, Location, FRotator::ZeroRotator, Params);
+		Characters[i]->EnableRollback(this);
+	}
+
+	if (PlController)
+		PlController->Possess(Characters[LocalPlayer]);
+}
+
+void ARollbackManager::SetupStonePool()
+{
+	// Stones placed in the map exist on both peers, sort them so both pools have the same order
+	for (TActorIterator<AStone> It(GetWorld()); It; ++It)
+		StonePool.Add(*It);
+	StonePool.Sort([](const AStone& A, const AStone& B) { return A.GetName() < B.GetName(); });
+	StonePool.SetNum(FMath::Min(StonePool.Num(), FRollbackFrameState::MaxStones));
+
+	UClass* StoneClass = Characters[0]->StoneClass ? *Characters[0]->StoneClass : AStone::StaticClass();
+	while (StonePool.Num() < FRollbackFrameState::MaxStones)
+	{
+		FActorSpawnParameters Params;
+		Params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		AStone* Stone = GetWorld()->SpawnActor<AStone>(StoneClass, FVector::ZeroVector, FRotator::ZeroRotator, Params);
+		Stone->SetRollbackActive(false);
+		StonePool.Add(Stone);
+	}
+
+	for (AStone* Stone : StonePool)
+		Stone->EnableRollback();
+}
+
+void ARollbackManager::LaunchStone(AWTFProjectCharacter* Thrower, const FVector& Location, const FVector& Direction)
+{
+	for (AStone* Stone : StonePool)
+	{
+		if (!Stone->IsRollbackActive())
+		{
+			Stone->Launch(Thrower, Location, Direction);
+			return;
+		}
+	}
+	UE_LOG(Rollback, Warning, TEXT("Stone pool exhausted"));
+}
+
+void ARollbackManager::ReleaseStone(AStone* Stone)
+{
+	if (Stone)
+		Stone->SetRollbackActive(false);
+}
+
+FRollbackInput ARollbackManager::SampleLocalInput() const
+{
+	AWTFProjectCharacter* Character = Characters[LocalPlayer];
+	FRollbackInput Input = Character->RollbackInput;
+	Input.SetAimDirection(Character->GetViewDirection());
+	return Input;
+}
+
+const FRollbackInput& ARollbackManager::GetInput(int32 Player, int32 Frame)
+{
+	const int32 Slot = Frame % BufferSize;
+	if (Player == LocalPlayer)
+		return LocalInputs[Slot];
+
+	if (RemoteInputFrames[Slot] != Frame)
+	{
+		// Not received yet: predict the last confirmed input and remember what was used
+		RemoteInputs[Slot] = LastConfirmedRemoteFrame >= 0 ? RemoteInputs[LastConfirmedRemoteFrame % BufferSize] : FRollbackInput();
+		RemoteInputFrames[Slot] = Frame;
+		RemoteConfirmed[Slot] = false;
+	}
+	return RemoteInputs[Slot];
+}
+
+void ARollbackManager::SaveState(int32 Frame)
+{
+	FRollbackFrameState& State = Snapshots[Frame % BufferSize];
+	State.Frame = Frame;
+	for (int32 i = 0; i < FRollbackFrameState::MaxPlayers; i++)
+	{
+		Characters[i]->SaveRollbackState(State.Characters[i]);
+		State.PreviousInputs[i] = PreviousInputs[i];
+	}
+	for (int32 i = 0; i < FRollbackFrameState::MaxStones; i++)
+		StonePool[i]->SaveRollbackState(State.Stones[i], Characters);
+}
+
+void ARollbackManager::LoadState(int32 Frame)
+{
+	const FRollbackFrameState& State = Snapshots[Frame % BufferSize];
+	check(State.Frame == Frame);
+	for (int32 i = 0; i < FRollbackFrameState::MaxPlayers; i++)
+	{
+		Characters[i]->LoadRollbackState(State.Characters[i]);
+		PreviousInputs[i] = State.PreviousInputs[i];
+	}
+	for (int32 i = 0; i < FRollbackFrameState::MaxStones; i++)
+		StonePool[i]->LoadRollbackState(State.Stones[i], Characters);
+}
+
+void ARollbackManager::SimulateFrame(int32 Frame)
+{
+	const float StepTime = 1.f / FixedStepRate;
+	for (int32 i = 0; i < FRollbackFrameState::MaxPlayers; i++)
+	{
+		const FRollbackInput& Input = GetInput(i, Frame);
+		Characters[i]->SimulateRollbackFrame(Input, PreviousInputs[i], StepTime);
+		PreviousInputs[i] = Input;
+	}
+	for (AStone* Stone : StonePool)
+		Stone->SimulateRollbackFrame(StepTime);
+}
+
+void ARollbackManager::AdvanceFrame()
+{
+	LocalInputs[CurrentFrame % BufferSize] = SampleLocalInput();
+	SaveState(CurrentFrame);
+	SimulateFrame(CurrentFrame);
+	CurrentFrame++;
+}
+
+void ARollbackManager::Rollback(int32 ToFrame)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RollbackResimulate);
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Unconfirmed frames still hold the prediction made from an older input, the resimulation would
+	// mispredict them the same way again. Predict them from the newest confirmed input instead.
+	const FRollbackInput Prediction = LastConfirmedRemoteFrame >= 0 ? RemoteInputs[LastConfirmedRemoteFrame % BufferSize] : FRollbackInput();
+	for (int32 Frame = LastConfirmedRemoteFrame + 1; Frame < CurrentFrame; Frame++)
+	{
+		const int32 Slot = Frame % BufferSize;
+		if (RemoteInputFrames[Slot] != Frame || RemoteConfirmed[Slot] || RemoteInputs[Slot] == Prediction)
+			continue;
+
+		// Out of order packets can leave a repredicted frame before the mismatch
+		RemoteInputs[Slot] = Prediction;
+		ToFrame = FMath::Min(ToFrame, Frame);
+	}
+
+	LoadState(ToFrame);
+	for (int32 Frame = ToFrame; Frame < CurrentFrame; Frame++)
+	{
+		if (Frame != ToFrame)
+			SaveState(Frame);
+		SimulateFrame(Frame);
+	}
+
+	INC_DWORD_STAT(STAT_Rollbacks);
+	INC_DWORD_STAT_BY(STAT_RollbackResimulatedFrames, CurrentFrame - ToFrame);
+
+	const double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	if (ElapsedMs > 1000.0 / FixedStepRate)
+		UE_LOG(Rollback, Warning, TEXT("Resimulating %d frames took %.2fms, over the frame budget"), CurrentFrame - ToFrame, ElapsedMs);
+}
+
+void ARollbackManager::SendInputs()
+{
+	const int32 FirstFrame = FMath::Max(LastAckedByRemote + 1, CurrentFrame - MaxRollbackFrames - 1);
+	uint8 Count = (uint8)FMath::Max(CurrentFrame - FirstFrame, 0);
+
+	PacketBuffer.Reset();
+	FMemoryWriter Writer(PacketBuffer);
+	uint32 Magic = RollbackPacketMagic;
+	int32 Ack = LastConfirmedRemoteFrame;
+	int32 First = FirstFrame;
+	Writer << Magic << Ack << First << Count;
+	for (int32 Frame = FirstFrame; Frame < CurrentFrame; Frame++)
+	{
+		FRollbackInput& Input = LocalInputs[Frame % BufferSize];
+		Writer << Input.MoveAxis << Input.Buttons << Input.AimX << Input.AimZ;
+	}
+
+	Transport.Send(PacketBuffer);
+}
+
+void ARollbackManager::ReceiveInputs()
+{
+	while (Transport.Receive(PacketBuffer))
+	{
+		FMemoryReader Reader(PacketBuffer);
+		uint32 Magic = 0;
+		int32 Ack = -1;
+		int32 FirstFrame = 0;
+		uint8 Count = 0;
+		Reader << Magic << Ack << FirstFrame << Count;
+		if (Reader.IsError() || Magic != RollbackPacketMagic)
+			continue;
+
+		LastAckedByRemote = FMath::Max(LastAckedByRemote, Ack);
+
+		for (int32 Frame = FirstFrame; Frame < FirstFrame + Count && !Reader.IsError(); Frame++)
+		{
+			FRollbackInput Input;
+			Reader << Input.MoveAxis << Input.Buttons << Input.AimX << Input.AimZ;
+			if (Frame <= LastConfirmedRemoteFrame || Reader.IsError())
+				continue;
+
+			const int32 Slot = Frame % BufferSize;
+			if (RemoteConfirmed[Slot] && RemoteInputFrames[Slot] == Frame)
+				continue;
+
+			// Already simulated with a prediction that turned out wrong
+			if (RemoteInputFrames[Slot] == Frame && Frame < CurrentFrame && RemoteInputs[Slot] != Input)
+				FirstMismatchFrame = FirstMismatchFrame == INDEX_NONE ? Frame : FMath::Min(FirstMismatchFrame, Frame);
+
+			RemoteInputs[Slot] = Input;
+			RemoteInputFrames[Slot] = Frame;
+			RemoteConfirmed[Slot] = true;
+		}
+
+		while (true)
+		{
+			const int32 Next = LastConfirmedRemoteFrame + 1;
+			const int32 Slot = Next % BufferSize;
+			if (!RemoteConfirmed[Slot] || RemoteInputFrames[Slot] != Next)
+				break;
+			LastConfirmedRemoteFrame = Next;
+		}
+	}
+}
+
+void ARollbackManager::Tick(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RollbackFrame);
+	Super::Tick(DeltaSeconds);
+
+	const float StepTime = 1.f / FixedStepRate;
+	StepAccumulator = FMath::Min(StepAccumulator + DeltaSeconds, StepTime * MaxRollbackFrames);
+
+	ReceiveInputs();
+
+	if (FirstMismatchFrame != INDEX_NONE)
+	{
+		Rollback(FirstMismatchFrame);
+		FirstMismatchFrame = INDEX_NONE;
+	}
+
+	while (StepAccumulator >= StepTime)
+	{
+		// Predicting further would need a rollback deeper than we allow, wait for the peer
+		if (CurrentFrame - LastConfirmedRemoteFrame > MaxRollbackFrames)
+		{
+			INC_DWORD_STAT(STAT_RollbackStalls);
+			break;
+		}
+
+		AdvanceFrame();
+		StepAccumulator -= StepTime;
+	}
+
+	SendInputs();
+	Transport.Flush();
+}
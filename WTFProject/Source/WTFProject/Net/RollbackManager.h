@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Net/RollbackTypes.h"
+#include "Net/RollbackTransport.h"
+#include "RollbackManager.generated.h"
+
+class AWTFProjectCharacter;
+class AStone;
+
+/**
+ * Peer-to-peer rollback session for a 1v1 stone duel, used instead of the client/server model when the
+ * game is started with -rollback. Both peers run a standalone world, exchange only inputs, and simulate
+ * both characters and a fixed pool of stones themselves at a fixed 60 Hz step.
+ *
+ * The remote input is predicted by repeating the last one received. When a real input arrives for a frame
+ * that was simulated with a wrong prediction, the state snapshot of that frame is restored and the frames
+ * up to the present are simulated again. The simulation is never allowed to run more than
+ * MaxRollbackFrames ahead of the last confirmed remote input.
+ *
+ * Command line: -rollback -rollbackplayer=0|1 -rollbackport=7000 -rollbackpeer=127.0.0.1:7001
+ *               [-rollbacklatency=ms] [-rollbackjitter=ms] [-rollbackloss=0..1]
+ */
+UCLASS(NotBlueprintable)
+class WTFPROJECT_API ARollbackManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	static const int32 MaxRollbackFrames = 8;
+	static const int32 BufferSize = 32;
+
+	ARollbackManager();
+
+	static bool IsRollbackRequested();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Takes an inactive stone from the pool instead of spawning an actor */
+	void LaunchStone(AWTFProjectCharacter* Thrower, const FVector& Location, const FVector& Direction);
+
+	/** Returns a picked stone to the pool instead of destroying it */
+	void ReleaseStone(AStone* Stone);
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	UPROPERTY(EditAnywhere, Category = "Rollback")
+	float FixedStepRate = 60.f;
+
+	/** Where player 0 and player 1 start, identical on both peers */
+	UPROPERTY(EditAnywhere, Category = "Rollback")
+	TArray<FVector> SpawnLocations;
+
+private:
+	void SetupCharacters();
+	void SetupStonePool();
+
+	FRollbackInput SampleLocalInput() const;
+	const FRollbackInput& GetInput(int32 Player, int32 Frame);
+
+	void SaveState(int32 Frame);
+	void LoadState(int32 Frame);
+	void SimulateFrame(int32 Frame);
+	void AdvanceFrame();
+	void Rollback(int32 ToFrame);
+
+	void SendInputs();
+	void ReceiveInputs();
+
+	UPROPERTY(Transient)
+	TArray<AWTFProjectCharacter*> Characters;
+
+	UPROPERTY(Transient)
+	TArray<AStone*> StonePool;
+
+	FRollbackTransport Transport;
+
+	int32 LocalPlayer = 0;
+	int32 RemotePlayer = 1;
+
+	int32 CurrentFrame = 0;
+	int32 LastConfirmedRemoteFrame = -1;
+	int32 LastAckedByRemote = -1;
+	int32 FirstMismatchFrame = INDEX_NONE;
+	float StepAccumulator = 0.f;
+
+	FRollbackFrameState Snapshots[BufferSize];
+	FRollbackInput LocalInputs[BufferSize];
+	FRollbackInput RemoteInputs[BufferSize];
+	int32 RemoteInputFrames[BufferSize];
+	bool RemoteConfirmed[BufferSize];
+	FRollbackInput PreviousInputs[FRollbackFrameState::MaxPlayers];
+
+	TArray<uint8> PacketBuffer;
+};
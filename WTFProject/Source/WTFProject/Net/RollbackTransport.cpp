@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "RollbackTransport.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+#include "Common/UdpSocketBuilder.h"
+
+DEFINE_LOG_CATEGORY_STATIC(RollbackTransport, Log, All);
+
+FRollbackTransport::~FRollbackTransport()
+{
+	Shutdown();
+}
+
+bool FRollbackTransport::Init(int32 LocalPort, const FString& PeerAddress, float InLatencyMs, float InJitterMs, float InLossRate)
+{
+	LatencyMs = FMath::Max(InLatencyMs, 0.f);
+	JitterMs = FMath::Max(InJitterMs, 0.f);
+	LossRate = FMath::Clamp(InLossRate, 0.f, 1.f);
+	Random.Initialize(LocalPort);
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	if (!SocketSubsystem)
+		return false;
+
+	FString PeerIp = PeerAddress;
+	FString PeerPortString;
+	PeerAddress.Split(TEXT(":"), &PeerIp, &PeerPortString);
+
+	bool bValidIp = false;
+	PeerAddr = SocketSubsystem->CreateInternetAddr();
+	PeerAddr->SetIp(*PeerIp, bValidIp);
+	PeerAddr->SetPort(FCString::Atoi(*PeerPortString));
+	if (!bValidIp)
+	{
+		UE_LOG(RollbackTransport, Error, TEXT("Invalid rollback peer address %s"), *PeerAddress);
+		return false;
+	}
+
+	Socket = FUdpSocketBuilder(TEXT("RollbackSocket"))
+		.AsNonBlocking()
+		.AsReusable()
+		.BoundToPort(LocalPort)
+		.WithReceiveBufferSize(64 * 1024)
+		.WithSendBufferSize(64 * 1024);
+
+	if (!Socket)
+	{
+		UE_LOG(RollbackTransport, Error, TEXT("Could not bind rollback socket to port %d"), LocalPort);
+		return false;
+	}
+
+	UE_LOG(RollbackTransport, Log, TEXT("Rollback link %d -> %s, latency %.0fms +- %.0fms, loss %.0f%%"), LocalPort, *PeerAddress, LatencyMs, JitterMs, LossRate * 100.f);
+	return true;
+}
+
+void FRollbackTransport::Shutdown()
+{
+	if (Socket)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+	Outgoing.Empty();
+}
+
+void FRollbackTransport::Send(const TArray<uint8>& Data)
+{
+	if (!Socket || Random.FRand() < LossRate)
+		return;
+
+	if (LatencyMs <= 0.f && JitterMs <= 0.f)
+	{
+		int32 BytesSent = 0;
+		Socket->SendTo(Data.GetData(), Data.Num(), BytesSent, *PeerAddr);
+		return;
+	}
+
+	FDelayedPacket& Packet = Outgoing[Outgoing.AddDefaulted()];
+	Packet.SendTime = FPlatformTime::Seconds() + (LatencyMs + Random.FRandRange(-JitterMs, JitterMs)) / 1000.0;
+	Packet.Data = Data;
+}
+
+void FRollbackTransport::Flush()
+{
+	if (!Socket)
+		return;
+
+	const double Now = FPlatformTime::Seconds();
+	int32 i = 0;
+	while (i < Outgoing.Num())
+	{
+		if (Outgoing[i].SendTime <= Now)
+		{
+			int32 BytesSent = 0;
+			Socket->SendTo(Outgoing[i].Data.GetData(), Outgoing[i].Data.Num(), BytesSent, *PeerAddr);
+			Outgoing.RemoveAt(i, 1, false);
+		}
+		else
+			i++;
+	}
+}
+
+bool FRollbackTransport::Receive(TArray<uint8>& OutData)
+{
+	uint32 PendingSize = 0;
+	if (!Socket || !Socket->HasPendingData(PendingSize))
+		return false;
+
+	OutData.SetNumUninitialized(FMath::Min(PendingSize, 65507u));
+	int32 BytesRead = 0;
+	TSharedRef<FInternetAddr> Sender = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+	if (!Socket->RecvFrom(OutData.GetData(), OutData.Num(), BytesRead, *Sender))
+		return false;
+
+	OutData.SetNum(BytesRead, false);
+	return true;
+}
@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+
+class FSocket;
+class FInternetAddr;
+
+/**
+ * Non-blocking UDP link to the other rollback peer. Outgoing packets can be held back by an artificial
+ * one-way latency (plus jitter) and randomly dropped, to test rollback locally with two processes.
+ */
+class FRollbackTransport
+{
+public:
+	~FRollbackTransport();
+
+	bool Init(int32 LocalPort, const FString& PeerAddress, float InLatencyMs, float InJitterMs, float InLossRate);
+	void Shutdown();
+
+	void Send(const TArray<uint8>& Data);
+	bool Receive(TArray<uint8>& OutData);
+
+	/** Sends the delayed packets that are due */
+	void Flush();
+
+	bool IsValid() const { return Socket != nullptr; }
+
+private:
+	struct FDelayedPacket
+	{
+		double SendTime;
+		TArray<uint8> Data;
+	};
+
+	FSocket* Socket = nullptr;
+	TSharedPtr<FInternetAddr> PeerAddr;
+	TArray<FDelayedPacket> Outgoing;
+	FRandomStream Random;
+
+	float LatencyMs = 0.f;
+	float JitterMs = 0.f;
+	float LossRate = 0.f;
+};
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/CharacterCore.h"
+
+namespace RollbackButtons
+{
+	enum Type : uint8
+	{
+		Jump = 1 << 0,
+		Throw = 1 << 1,
+		Pick = 1 << 2
+	};
+}
+
+/**
+ * Input of one player for one simulation frame. Buttons are held states, presses and releases are
+ * derived by comparing with the previous frame, so repeating the last known input is a sane prediction.
+ */
+struct FRollbackInput
+{
+	int8 MoveAxis = 0;
+	uint8 Buttons = 0;
+	int16 AimX = 0;
+	int16 AimZ = 0;
+
+	void SetMoveAxis(float Value) { MoveAxis = (int8)FMath::Clamp(FMath::RoundToInt(Value * 127.f), -127, 127); }
+	float GetMoveAxis() const { return MoveAxis / 127.f; }
+
+	void SetAimDirection(const FVector& Direction)
+	{
+		AimX = (int16)FMath::Clamp(FMath::RoundToInt(Direction.X * 32767.f), -32767, 32767);
+		AimZ = (int16)FMath::Clamp(FMath::RoundToInt(Direction.Z * 32767.f), -32767, 32767);
+	}
+	FVector GetAimDirection() const { return FVector(AimX / 32767.f, 0.f, AimZ / 32767.f).GetSafeNormal(); }
+
+	bool IsHeld(RollbackButtons::Type Button) const { return (Buttons & Button) != 0; }
+	bool WasPressed(const FRollbackInput& Previous, RollbackButtons::Type Button) const { return IsHeld(Button) && !Previous.IsHeld(Button); }
+	bool WasReleased(const FRollbackInput& Previous, RollbackButtons::Type Button) const { return !IsHeld(Button) && Previous.IsHeld(Button); }
+
+	bool operator==(const FRollbackInput& Other) const
+	{
+		return MoveAxis == Other.MoveAxis && Buttons == Other.Buttons && AimX == Other.AimX && AimZ == Other.AimZ;
+	}
+	bool operator!=(const FRollbackInput& Other) const { return !(*this == Other); }
+};
+
+/** Everything about a character that affects the outcome of later frames: the rules state plus the body */
+struct FRollbackCharacterState
+{
+	WTFCore::FCharacterState Core;
+
+	FVector Location = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+	float JumpKeyHoldTime = 0.f;
+	int32 JumpCurrentCount = 0;
+	uint8 MovementMode = 0;
+	bool bPressedJump = false;
+	bool bWasJumping = false;
+};
+
+struct FRollbackStoneState
+{
+	FVector Location = FVector::ZeroVector;
+	FRotator Rotation = FRotator::ZeroRotator;
+	FVector Velocity = FVector::ZeroVector;
+	float GravityScale = 1.f;
+	int8 InstigatorIndex = -1;
+	bool bActive = false;
+	bool bSimulating = false;
+	bool bCanDealDamage = false;
+};
+
+/** Snapshot of the whole duel taken at the start of a frame, stored in a preallocated ring */
+struct FRollbackFrameState
+{
+	static const int32 MaxPlayers = 2;
+	static const int32 MaxStones = 16;
+
+	int32 Frame = -1;
+	FRollbackCharacterState Characters[MaxPlayers];
+	FRollbackInput PreviousInputs[MaxPlayers];
+	FRollbackStoneState Stones[MaxStones];
+};
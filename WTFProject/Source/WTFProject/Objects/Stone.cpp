@@ -2,6 +2,10 @@
 
 #include "Stone.h"
 #include "WTFProjectCharacter.h"
+#include "Debug/GameplayEventRecorder.h"
+#include "Net/ProjectileStream.h"
+#include "Engine/ActorChannel.h"
+#include "Net/DataBunch.h"
 
 AStone::AStone()
 {
@@ -22,17 +26,146 @@ AStone::AStone()
 	MovementComponent->SetPlaneConstraintNormal(FVector(0.0f, -1.0f, 0.0f));
 }
 
+void AStone::BeginPlay()
+{
+	Super::BeginPlay();
+	FGameplayEventRecorder::Record(EGameplayEventType::GE_Spawn, this, 0, GetActorLocation());
+}
+
+void AStone::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (Stream.IsValid())
+		Stream->OnStoneRemoved(StreamId);
+	Super::EndPlay(EndPlayReason);
+}
+
+#if WITH_PROJECTILE_NET_STATS
+bool AStone::ReplicateSubobjects(UActorChannel* Channel, FOutBunch* Bunch, FReplicationFlags* RepFlags)
+{
+	const bool bWroteSomething = Super::ReplicateSubobjects(Channel, Bunch, RepFlags);
+	// Spawn info and properties of this update are all in the bunch by now
+	FProjectileNetStats::ActorBits += Bunch->GetNumBits();
+	return bWroteSomething;
+}
+#endif
+
 bool AStone::CanBePicked()
 {
-	return !bCanDealDamage;
+	return !bCanDealDamage && bRollbackActive;
+}
+
+float AStone::GetLaunchSpeed() const
+{
+	return MovementComponent->InitialSpeed > 0.f ? MovementComponent->InitialSpeed : MovementComponent->Velocity.Size();
+}
+
+float AStone::GetLaunchGravityScale() const
+{
+	return MovementComponent->ProjectileGravityScale;
+}
+
+void AStone::EnableRollback()
+{
+	MovementComponent->SetComponentTickEnabled(false);
+}
+
+void AStone::SetRollbackActive(bool bActive)
+{
+	bRollbackActive = bActive;
+	SetActorHiddenInGame(!bActive);
+	SetActorEnableCollision(bActive);
+	if (!bActive)
+	{
+		MovementComponent->Velocity = FVector::ZeroVector;
+		MovementComponent->SetUpdatedComponent(nullptr);
+	}
+}
+
+void AStone::Launch(AWTFProjectCharacter* Thrower, const FVector& Location, const FVector& Direction)
+{
+	const AStone* DefaultStone = GetClass()->GetDefaultObject<AStone>();
+	const float Speed = DefaultStone->GetLaunchSpeed();
+
+	SetActorLocationAndRotation(Location, Direction.Rotation(), false, nullptr, ETeleportType::TeleportPhysics);
+	Instigator = Thrower;
+	bCanDealDamage = true;
+	SetRollbackActive(true);
+	MovementComponent->SetUpdatedComponent(CollisionSphere);
+	MovementComponent->ProjectileGravityScale = DefaultStone->GetLaunchGravityScale();
+	MovementComponent->Velocity = Direction.GetSafeNormal() * Speed;
+}
+
+void AStone::SaveRollbackState(FRollbackStoneState& State, const TArray<AWTFProjectCharacter*>& Characters) const
+{
+	State.Location = GetActorLocation();
+	State.Rotation = GetActorRotation();
+	State.Velocity = MovementComponent->Velocity;
+	State.GravityScale = MovementComponent->ProjectileGravityScale;
+	State.InstigatorIndex = (int8)Characters.IndexOfByPredicate([this](const AWTFProjectCharacter* Character) { return Character == Instigator; });
+	State.bActive = bRollbackActive;
+	State.bSimulating = MovementComponent->UpdatedComponent != nullptr;
+	State.bCanDealDamage = bCanDealDamage;
+}
+
+void AStone::LoadRollbackState(const FRollbackStoneState& State, const TArray<AWTFProjectCharacter*>& Characters)
+{
+	if (State.bActive != bRollbackActive)
+		SetRollbackActive(State.bActive);
+
+	SetActorLocationAndRotation(State.Location, State.Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	MovementComponent->SetUpdatedComponent(State.bSimulating ? CollisionSphere : nullptr);
+	MovementComponent->Velocity = State.Velocity;
+	MovementComponent->ProjectileGravityScale = State.GravityScale;
+	Instigator = Characters.IsValidIndex(State.InstigatorIndex) ? Characters[State.InstigatorIndex] : nullptr;
+	bCanDealDamage = State.bCanDealDamage;
+}
+
+void AStone::SimulateRollbackFrame(float DeltaTime)
+{
+	if (bRollbackActive && MovementComponent->UpdatedComponent)
+		MovementComponent->TickComponent(DeltaTime, LEVELTICK_All, nullptr);
+}
+
+void AStone::SetStreamed(AProjectileStream* InStream, int32 Id)
+{
+	Stream = InStream;
+	StreamId = Id;
+}
+
+void AStone::CorrectImpact(const FVector& Location)
+{
+	// A hit seen locally already put the stone on its falling path, keep that
+	if (!bCanDealDamage)
+		return;
+
+	SetActorLocation(Location, false, nullptr, ETeleportType::TeleportPhysics);
+	Impact(FHitResult(), false);
+}
+
+void AStone::FastForward(float Seconds)
+{
+	const float Step = 1.f / 30.f;
+	for (float Time = 0.f; Time < Seconds && MovementComponent->UpdatedComponent; Time += Step)
+		MovementComponent->TickComponent(FMath::Min(Step, Seconds - Time), LEVELTICK_All, nullptr);
+}
+
+bool AStone::IsResting() const
+{
+	return !bCanDealDamage && (!MovementComponent->UpdatedComponent || MovementComponent->Velocity.IsNearlyZero());
+}
+
+void AStone::Impact(const FHitResult& Hit, bool bHitCharacter)
+{
+	bCanDealDamage = false;
+	FGameplayEventRecorder::Record(EGameplayEventType::GE_Hit, this, bHitCharacter ? 1 : 0, GetActorLocation());
+	MovementComponent->HandleImpact(Hit);
+	if (Stream.IsValid())
+		Stream->OnStoneImpact(StreamId, GetActorLocation());
 }
 
 void AStone::OnHit(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult &SweepResult)
 {
 	AWTFProjectCharacter* HitChar = Cast<AWTFProjectCharacter>(OtherActor);
 	if (bCanDealDamage && (!HitChar || HitChar != GetInstigator()))
-	{
-		bCanDealDamage = false;
-		MovementComponent->HandleImpact(SweepResult);
-	}
+		Impact(SweepResult, HitChar != nullptr);
 }
@@ -3,12 +3,15 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "WTFProject.h"
 #include "Components/SphereComponent.h"
 #include "../../Engine/Plugins/2D/Paper2D/Source/Paper2D/Classes/PaperSpriteComponent.h"
 #include "Components/ProjectileMovement.h"
+#include "Net/RollbackTypes.h"
 #include "Stone.generated.h"
 
 class AWTFProjectCharacter;
+class AProjectileStream;
 
 /**
  * 
@@ -23,6 +26,37 @@ public:
 
 	bool CanBePicked();
 
+	/** Speed and gravity scale a stone of this class is thrown with, call on the class default object */
+	float GetLaunchSpeed() const;
+	float GetLaunchGravityScale() const;
+
+	/** Pooled stones driven by ARollbackManager instead of their own tick */
+	void EnableRollback();
+	void SetRollbackActive(bool bActive);
+	bool IsRollbackActive() const { return bRollbackActive; }
+	void Launch(AWTFProjectCharacter* Thrower, const FVector& Location, const FVector& Direction);
+	void SaveRollbackState(FRollbackStoneState& State, const TArray<AWTFProjectCharacter*>& Characters) const;
+	void LoadRollbackState(const FRollbackStoneState& State, const TArray<AWTFProjectCharacter*>& Characters);
+	void SimulateRollbackFrame(float DeltaTime);
+
+	/** Server stone of an AProjectileStream event, reports its impact and removal to the stream */
+	void SetStreamed(AProjectileStream* Stream, int32 Id);
+	/** Moves a client stone to where the server stone hit, if this client didn't see the hit itself */
+	void CorrectImpact(const FVector& Location);
+	/** Simulates Seconds at once, for stones whose throw event arrived late */
+	void FastForward(float Seconds);
+	/** Hit something and stopped moving */
+	bool IsResting() const;
+
+#if WITH_PROJECTILE_NET_STATS
+	/** Only adds the bits of each update to FProjectileNetStats */
+	virtual bool ReplicateSubobjects(class UActorChannel* Channel, class FOutBunch* Bunch, FReplicationFlags* RepFlags) override;
+#endif
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 private:
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"), Category = Components)
@@ -36,6 +70,13 @@ private:
 
 	bool bCanDealDamage = true;
 
+	bool bRollbackActive = true;
+
+	TWeakObjectPtr<AProjectileStream> Stream;
+	int32 StreamId = INDEX_NONE;
+
+	void Impact(const FHitResult& Hit, bool bHitCharacter);
+
 	UFUNCTION()
 	void OnHit(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult &SweepResult);
 };
@@ -0,0 +1,529 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "StoneStorm.h"
+#include "WTFProject.h"
+#include "WTFProjectCharacter.h"
+#include "Debug/GameplayEventRecorder.h"
+#include "PaperGroupedSpriteComponent.h"
+#include "PaperSprite.h"
+#include "PaperSpriteComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "GameFramework/PlayerController.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/VectorRegister.h"
+
+DEFINE_LOG_CATEGORY_STATIC(StoneStorm, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("Stone Storm Simulate"), STAT_StoneStormSimulate, STATGROUP_WTFProject);
+DECLARE_CYCLE_STAT(TEXT("Stone Storm Render Update"), STAT_StoneStormRender, STATGROUP_WTFProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Stone Storm Stones"), STAT_StoneStormStones, STATGROUP_WTFProject);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdStoneStormBenchmark(
+	TEXT("wtf.StoneStorm.Benchmark"),
+	TEXT("wtf.StoneStorm.Benchmark [Count=10000] [Frames=300] [Characters=16]: measures the stone storm simulation against the 2 ms budget."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000;
+		const int32 Frames = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 300;
+		const int32 NumCapsules = Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 16;
+		AStoneStormManager::RunBenchmark(World, Count, Frames, NumCapsules);
+	}));
+
+namespace
+{
+	AWTFProjectCharacter* GetLocalCharacter(UWorld* World)
+	{
+		APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+		return PlayerController ? Cast<AWTFProjectCharacter>(PlayerController->GetPawn()) : nullptr;
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdStoneStormRain(
+	TEXT("wtf.StoneStorm.Rain"),
+	TEXT("wtf.StoneStorm.Rain [Count=200] [Width=4000] [Height=1500]: lets stones rain around the local player."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		AWTFProjectCharacter* Character = GetLocalCharacter(World);
+		AStoneStormManager* Manager = AStoneStormManager::FindOrSpawn(World, Character);
+		if (!Manager)
+			return;
+
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 200;
+		const float Width = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 4000.f;
+		const float Height = Args.Num() > 2 ? FCString::Atof(*Args[2]) : 1500.f;
+		const FVector Center = Character->GetActorLocation();
+		Manager->SpawnRain(Count, Center.X - Width * 0.5f, Center.X + Width * 0.5f, Center.Z + Height);
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdStoneStormThrow(
+	TEXT("wtf.StoneStorm.Throw"),
+	TEXT("wtf.StoneStorm.Throw [Count=5] [Spread=30] [Speed=1500]: throws a fan of stones from the local player in its facing direction."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		AWTFProjectCharacter* Character = GetLocalCharacter(World);
+		AStoneStormManager* Manager = AStoneStormManager::FindOrSpawn(World, Character);
+		if (!Manager)
+			return;
+
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 5;
+		const float Spread = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 30.f;
+		const float Speed = Args.Num() > 2 ? FCString::Atof(*Args[2]) : 1500.f;
+		Manager->ThrowSpread(Character, Character->GetActorLocation(), Character->GetActorForwardVector(), Speed, Count, Spread);
+	}));
+
+AStoneStormManager::AStoneStormManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+
+	SpriteInstances = CreateDefaultSubobject<UPaperGroupedSpriteComponent>(TEXT("SpriteInstances"));
+	SpriteInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	RootComponent = SpriteInstances;
+}
+
+void AStoneStormManager::Grow(int32 NewCapacity)
+{
+	NewCapacity = Align(FMath::Max(NewCapacity, 4), 4);
+	if (NewCapacity <= Capacity)
+		return;
+
+	PosX.SetNumZeroed(NewCapacity);
+	PosZ.SetNumZeroed(NewCapacity);
+	VelX.SetNumZeroed(NewCapacity);
+	VelZ.SetNumZeroed(NewCapacity);
+	GravityScale.SetNumZeroed(NewCapacity);
+	Moving.SetNumZeroed(NewCapacity);
+	FlightTime.SetNumZeroed(NewCapacity);
+	State.SetNumZeroed(NewCapacity);
+	CanDealDamage.SetNumZeroed(NewCapacity);
+	Owner.SetNum(NewCapacity);
+
+	// Lowest indices are handed out first
+	for (int32 i = NewCapacity - 1; i >= Capacity; i--)
+		FreeList.Add(i);
+
+	if (bRender)
+	{
+		for (int32 i = Capacity; i < NewCapacity; i++)
+			SpriteInstances->AddInstance(FTransform(FRotator::ZeroRotator, FVector::ZeroVector, FVector::ZeroVector), StoneSprite, true);
+	}
+
+	Capacity = NewCapacity;
+}
+
+int32 AStoneStormManager::SpawnStone(const FVector& Location, const FVector& Velocity, AWTFProjectCharacter* InOwner)
+{
+	if (FreeList.Num() == 0)
+		Grow(FMath::Max(Capacity * 2, InitialCapacity));
+
+	const int32 Index = FreeList.Pop(false);
+	PosX[Index] = Location.X;
+	PosZ[Index] = Location.Z;
+	VelX[Index] = Velocity.X;
+	VelZ[Index] = Velocity.Z;
+	GravityScale[Index] = FlyingGravityScale;
+	Moving[Index] = 1.f;
+	FlightTime[Index] = 0.f;
+	State[Index] = SS_Flying;
+	CanDealDamage[Index] = true;
+	Owner[Index] = InOwner;
+	NumAlive++;
+
+	FGameplayEventRecorder::Record(EGameplayEventType::GE_Spawn, this, 1, Location);
+	return Index;
+}
+
+void AStoneStormManager::ThrowSpread(AWTFProjectCharacter* InOwner, const FVector& Origin, const FVector& Direction, float Speed, int32 Count, float SpreadDegrees)
+{
+	const float BaseAngle = FMath::Atan2(Direction.Z, Direction.X);
+	const float Step = Count > 1 ? FMath::DegreesToRadians(SpreadDegrees) / (Count - 1) : 0.f;
+	const float FirstAngle = BaseAngle - Step * (Count - 1) * 0.5f;
+	for (int32 i = 0; i < Count; i++)
+	{
+		const float Angle = FirstAngle + Step * i;
+		SpawnStone(Origin, FVector(FMath::Cos(Angle), 0.f, FMath::Sin(Angle)) * Speed, InOwner);
+	}
+}
+
+void AStoneStormManager::SpawnRain(int32 Count, float MinX, float MaxX, float Height)
+{
+	for (int32 i = 0; i < Count; i++)
+	{
+		const FVector Location(FMath::FRandRange(MinX, MaxX), 0.f, Height + FMath::FRandRange(0.f, 512.f));
+		const int32 Index = SpawnStone(Location, FVector(FMath::FRandRange(-50.f, 50.f), 0.f, -FMath::FRandRange(200.f, 600.f)), nullptr);
+		GravityScale[Index] = 1.f;
+	}
+}
+
+void AStoneStormManager::KillStone(int32 Index)
+{
+	State[Index] = SS_Free;
+	Moving[Index] = 0.f;
+	VelX[Index] = 0.f;
+	VelZ[Index] = 0.f;
+	CanDealDamage[Index] = false;
+	Owner[Index] = nullptr;
+	FreeList.Add(Index);
+	NumAlive--;
+}
+
+AStoneStormManager* AStoneStormManager::FindOrSpawn(UWorld* World, AWTFProjectCharacter* Character)
+{
+	if (!World || !Character)
+	{
+		UE_LOG(StoneStorm, Warning, TEXT("The stone storm commands need a local player character"));
+		return nullptr;
+	}
+
+	// Benchmark managers do not render and are skipped
+	for (TActorIterator<AStoneStormManager> It(World); It; ++It)
+	{
+		if (It->bRender)
+			return *It;
+	}
+
+	const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+	const UPaperSpriteComponent* HeldStone = Character->FindComponentByClass<UPaperSpriteComponent>();
+
+	FActorSpawnParameters Params;
+	Params.bDeferConstruction = true;
+	AStoneStormManager* Manager = World->SpawnActor<AStoneStormManager>(AStoneStormManager::StaticClass(), FTransform::Identity, Params);
+	Manager->GroundZ = Character->GetActorLocation().Z - Capsule->GetScaledCapsuleHalfHeight();
+	Manager->StoneSprite = HeldStone ? HeldStone->GetSprite() : nullptr;
+	Manager->FinishSpawning(FTransform::Identity);
+	return Manager;
+}
+
+bool AStoneStormManager::TryPickStone(const FVector& Feet, float Radius)
+{
+	int32 Best = INDEX_NONE;
+	float BestDistSqr = Radius * Radius;
+	for (int32 i = 0; i < Capacity; i++)
+	{
+		// Same as AStone::CanBePicked, any stone that has hit something
+		if (State[i] == SS_Free || CanDealDamage[i])
+			continue;
+
+		const float DistSqr = FMath::Square(PosX[i] - Feet.X) + FMath::Square(PosZ[i] - Feet.Z);
+		if (DistSqr <= BestDistSqr)
+		{
+			BestDistSqr = DistSqr;
+			Best = i;
+		}
+	}
+
+	if (Best == INDEX_NONE)
+		return false;
+
+	KillStone(Best);
+	return true;
+}
+
+bool AStoneStormManager::TryPickStoneInWorld(UWorld* World, const FVector& Feet, float Radius)
+{
+	if (!World)
+		return false;
+
+	for (TActorIterator<AStoneStormManager> It(World); It; ++It)
+	{
+		if (It->TryPickStone(Feet, Radius))
+			return true;
+	}
+	return false;
+}
+
+void AStoneStormManager::Integrate(float DeltaTime)
+{
+	const float GravityZ = GetWorld() ? GetWorld()->GetGravityZ() : -980.f;
+	const VectorRegister Dt = VectorSetFloat1(DeltaTime);
+	const VectorRegister GravityDt = VectorSetFloat1(GravityZ * DeltaTime);
+
+	float* RESTRICT PX = PosX.GetData();
+	float* RESTRICT PZ = PosZ.GetData();
+	float* RESTRICT VX = VelX.GetData();
+	float* RESTRICT VZ = VelZ.GetData();
+	const float* RESTRICT G = GravityScale.GetData();
+	const float* RESTRICT M = Moving.GetData();
+
+	// Capacity is always a multiple of four and the arrays are 16 byte aligned
+	for (int32 i = 0; i < Capacity; i += 4)
+	{
+		const VectorRegister MovingDt = VectorMultiply(VectorLoadAligned(M + i), Dt);
+		const VectorRegister MovingGravity = VectorMultiply(VectorLoadAligned(M + i), GravityDt);
+
+		const VectorRegister NewVZ = VectorMultiplyAdd(VectorLoadAligned(G + i), MovingGravity, VectorLoadAligned(VZ + i));
+		VectorStoreAligned(NewVZ, VZ + i);
+		VectorStoreAligned(VectorMultiplyAdd(VectorLoadAligned(VX + i), MovingDt, VectorLoadAligned(PX + i)), PX + i);
+		VectorStoreAligned(VectorMultiplyAdd(NewVZ, MovingDt, VectorLoadAligned(PZ + i)), PZ + i);
+	}
+}
+
+void AStoneStormManager::BuildGrid()
+{
+	Capsules.Reset();
+	UWorld* World = GetWorld();
+	if (!World)
+		return;
+
+	if (DummyCapsules.Num() > 0)
+	{
+		Capsules = DummyCapsules;
+	}
+	else
+	{
+		for (TActorIterator<AWTFProjectCharacter> It(World); It; ++It)
+		{
+			const UCapsuleComponent* Capsule = It->GetCapsuleComponent();
+			const FVector Location = It->GetActorLocation();
+			FCapsule2D& Entry = Capsules[Capsules.AddUninitialized()];
+			Entry.Character = *It;
+			Entry.X = Location.X;
+			Entry.Z = Location.Z;
+			Entry.Radius = Capsule->GetScaledCapsuleRadius() + StoneRadius;
+			Entry.HalfSegment = Capsule->GetScaledCapsuleHalfHeight_WithoutHemisphere();
+		}
+	}
+
+	float MinX = MAX_flt, MaxX = -MAX_flt, MinZ = MAX_flt, MaxZ = -MAX_flt;
+	for (const FCapsule2D& Entry : Capsules)
+	{
+		MinX = FMath::Min(MinX, Entry.X - Entry.Radius);
+		MaxX = FMath::Max(MaxX, Entry.X + Entry.Radius);
+		MinZ = FMath::Min(MinZ, Entry.Z - Entry.HalfSegment - Entry.Radius);
+		MaxZ = FMath::Max(MaxZ, Entry.Z + Entry.HalfSegment + Entry.Radius);
+	}
+
+	GridSizeX = GridSizeZ = 0;
+	if (Capsules.Num() == 0)
+		return;
+
+	// Players far apart would make a huge sparse grid, coarsen the cells instead
+	const int32 MaxCells = 4096;
+	GridCellSize = FMath::Max(CellSize, 1.f);
+	while (FMath::CeilToInt((MaxX - MinX) / GridCellSize + 1) * FMath::CeilToInt((MaxZ - MinZ) / GridCellSize + 1) > MaxCells)
+		GridCellSize *= 2.f;
+
+	GridMinX = FMath::FloorToInt(MinX / GridCellSize);
+	GridMinZ = FMath::FloorToInt(MinZ / GridCellSize);
+	GridSizeX = FMath::FloorToInt(MaxX / GridCellSize) - GridMinX + 1;
+	GridSizeZ = FMath::FloorToInt(MaxZ / GridCellSize) - GridMinZ + 1;
+
+	// Counting sort of capsule indices into cells, cell N owns CellEntries[CellStart[N], CellStart[N + 1])
+	CellStart.SetNumZeroed(GridSizeX * GridSizeZ + 1);
+	for (int32 Pass = 0; Pass < 2; Pass++)
+	{
+		if (Pass == 1)
+		{
+			for (int32 Cell = 1; Cell < CellStart.Num(); Cell++)
+				CellStart[Cell] += CellStart[Cell - 1];
+			CellEntries.SetNumUninitialized(CellStart.Last());
+			CellCursor = CellStart;
+		}
+
+		for (int32 c = 0; c < Capsules.Num(); c++)
+		{
+			const FCapsule2D& Entry = Capsules[c];
+			const int32 X0 = FMath::FloorToInt((Entry.X - Entry.Radius) / GridCellSize) - GridMinX;
+			const int32 X1 = FMath::FloorToInt((Entry.X + Entry.Radius) / GridCellSize) - GridMinX;
+			const int32 Z0 = FMath::FloorToInt((Entry.Z - Entry.HalfSegment - Entry.Radius) / GridCellSize) - GridMinZ;
+			const int32 Z1 = FMath::FloorToInt((Entry.Z + Entry.HalfSegment + Entry.Radius) / GridCellSize) - GridMinZ;
+			for (int32 Z = Z0; Z <= Z1; Z++)
+			{
+				for (int32 X = X0; X <= X1; X++)
+				{
+					const int32 Cell = Z * GridSizeX + X;
+					if (Pass == 0)
+						CellStart[Cell + 1]++;
+					else
+						CellEntries[CellCursor[Cell]++] = c;
+				}
+			}
+		}
+	}
+}
+
+void AStoneStormManager::CollideCharacters(float DeltaTime)
+{
+	const float MinRestZ = GroundZ + StoneRadius;
+	const float KillZ = GetWorld() && GetWorld()->GetWorldSettings() ? GetWorld()->GetWorldSettings()->KillZ : -HALF_WORLD_MAX;
+	for (int32 i = 0; i < Capacity; i++)
+	{
+		if (Moving[i] == 0.f)
+			continue;
+
+		// A stone thrown without gravity that misses everyone would never land
+		FlightTime[i] += DeltaTime;
+		if (FlightTime[i] > MaxFlightTime || PosZ[i] < KillZ || FMath::Abs(PosX[i]) > HALF_WORLD_MAX || FMath::Abs(PosZ[i]) > HALF_WORLD_MAX)
+		{
+			KillStone(i);
+			continue;
+		}
+
+		if (PosZ[i] <= MinRestZ && VelZ[i] <= 0.f)
+		{
+			PosZ[i] = MinRestZ;
+			VelX[i] = VelZ[i] = 0.f;
+			Moving[i] = 0.f;
+			State[i] = SS_Resting;
+			CanDealDamage[i] = false;
+			continue;
+		}
+
+		if (!CanDealDamage[i] || GridSizeX == 0)
+			continue;
+
+		const int32 X = FMath::FloorToInt(PosX[i] / GridCellSize) - GridMinX;
+		const int32 Z = FMath::FloorToInt(PosZ[i] / GridCellSize) - GridMinZ;
+		if (X < 0 || Z < 0 || X >= GridSizeX || Z >= GridSizeZ)
+			continue;
+
+		const int32 Cell = Z * GridSizeX + X;
+		for (int32 Entry = CellStart[Cell]; Entry < CellStart[Cell + 1]; Entry++)
+		{
+			const FCapsule2D& Capsule = Capsules[CellEntries[Entry]];
+			const float DX = PosX[i] - Capsule.X;
+			const float LocalZ = PosZ[i] - Capsule.Z;
+			const float DZ = LocalZ - FMath::Clamp(LocalZ, -Capsule.HalfSegment, Capsule.HalfSegment);
+			if (DX * DX + DZ * DZ > Capsule.Radius * Capsule.Radius || (Capsule.Character && Owner[i].Get() == Capsule.Character))
+				continue;
+
+			// Same outcome as AStone::OnHit followed by UProjectileMovement::HandleImpact
+			CanDealDamage[i] = false;
+			GravityScale[i] = 1.f;
+			VelX[i] = -VelX[i] * Bounciness;
+			State[i] = SS_Falling;
+
+			const FVector Location(PosX[i], 0.f, PosZ[i]);
+			FGameplayEventRecorder::Record(EGameplayEventType::GE_Hit, this, 1, Location);
+			OnStoneHit.Broadcast(Capsule.Character, Location);
+			break;
+		}
+	}
+}
+
+void AStoneStormManager::Simulate(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_StoneStormSimulate);
+
+	Integrate(DeltaTime);
+	BuildGrid();
+	CollideCharacters(DeltaTime);
+}
+
+void AStoneStormManager::UpdateInstances()
+{
+	SCOPE_CYCLE_COUNTER(STAT_StoneStormRender);
+
+	const int32 NumInstances = FMath::Min(Capacity, SpriteInstances->GetInstanceCount());
+	for (int32 i = 0; i < NumInstances; i++)
+	{
+		const FVector Scale = State[i] == SS_Free ? FVector::ZeroVector : FVector::OneVector;
+		SpriteInstances->UpdateInstanceTransform(i, FTransform(FRotator::ZeroRotator, FVector(PosX[i], 0.f, PosZ[i]), Scale), true, false);
+	}
+	SpriteInstances->MarkRenderStateDirty();
+}
+
+void AStoneStormManager::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (Capacity == 0 && InitialCapacity > 0)
+		Grow(InitialCapacity);
+
+	Simulate(DeltaSeconds);
+	if (bRender)
+		UpdateInstances();
+
+	SET_DWORD_STAT(STAT_StoneStormStones, NumAlive);
+}
+
+bool AStoneStormManager::CheckPickup()
+{
+	// A character stands on the floor at X = 0, a stone dropped right next to it must be pickable once it rests
+	const UCapsuleComponent* Capsule = GetDefault<AWTFProjectCharacter>()->GetCapsuleComponent();
+	const float Radius = Capsule->GetScaledCapsuleRadius();
+	const float HalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+	const int32 Index = SpawnStone(FVector(Radius + StoneRadius + 10.f, 0.f, GroundZ + HalfHeight), FVector::ZeroVector, nullptr);
+	GravityScale[Index] = 1.f;
+	for (int32 Frame = 0; Frame < 120 && State[Index] != SS_Resting; Frame++)
+		Simulate(1.f / 60.f);
+
+	// Same feet and radius as AWTFProjectCharacter::Pick
+	return TryPickStone(FVector(0.f, 0.f, GroundZ), Radius * 2.f);
+}
+
+void AStoneStormManager::RunBenchmark(UWorld* World, int32 Count, int32 Frames, int32 NumCapsules)
+{
+	if (!World || Count <= 0 || Frames <= 0)
+		return;
+
+	FActorSpawnParameters Params;
+	Params.bDeferConstruction = true;
+	AStoneStormManager* Manager = World->SpawnActor<AStoneStormManager>(AStoneStormManager::StaticClass(), FTransform::Identity, Params);
+	Manager->bRender = false;
+	Manager->SetActorTickEnabled(false);
+	Manager->GroundZ = -1000000.f;
+	Manager->FinishSpawning(FTransform::Identity);
+
+	// The world may have no characters, stand-ins keep the broad phase in the measurement
+	const UCapsuleComponent* CharacterCapsule = GetDefault<AWTFProjectCharacter>()->GetCapsuleComponent();
+	for (int32 i = 0; i < NumCapsules; i++)
+	{
+		FCapsule2D& Entry = Manager->DummyCapsules[Manager->DummyCapsules.AddUninitialized()];
+		Entry.Character = nullptr;
+		Entry.X = FMath::FRandRange(-8000.f, 8000.f);
+		Entry.Z = FMath::FRandRange(0.f, 2000.f);
+		Entry.Radius = CharacterCapsule->GetScaledCapsuleRadius() + Manager->StoneRadius;
+		Entry.HalfSegment = CharacterCapsule->GetScaledCapsuleHalfHeight_WithoutHemisphere();
+	}
+
+	Manager->Grow(Count);
+	for (int32 i = 0; i < Count; i++)
+	{
+		const FVector Location(FMath::FRandRange(-8000.f, 8000.f), 0.f, FMath::FRandRange(0.f, 2000.f));
+		const FVector Velocity(FMath::FRandRange(-1500.f, 1500.f), 0.f, FMath::FRandRange(-500.f, 1000.f));
+		Manager->SpawnStone(Location, Velocity, nullptr);
+	}
+
+	double TotalMs = 0.0;
+	double MaxMs = 0.0;
+	for (int32 Frame = 0; Frame < Frames; Frame++)
+	{
+		const double Start = FPlatformTime::Seconds();
+		Manager->Simulate(1.f / 60.f);
+		const double Ms = (FPlatformTime::Seconds() - Start) * 1000.0;
+		TotalMs += Ms;
+		MaxMs = FMath::Max(MaxMs, Ms);
+	}
+
+	const double AvgMs = TotalMs / Frames;
+	UE_LOG(StoneStorm, Display, TEXT("Stone storm benchmark: %d stones, %d capsules, %d frames, avg %.3fms, max %.3fms, budget 2ms %s"),
+		Count, NumCapsules, Frames, AvgMs, MaxMs, MaxMs <= 2.0 ? TEXT("met") : TEXT("MISSED"));
+
+	// Spawns and hits also go through the always-on flight recorder, its cost per event has to stay well under a microsecond
+	const double RecordStart = FPlatformTime::Seconds();
+	for (int32 i = 0; i < Count; i++)
+		FGameplayEventRecorder::Record(EGameplayEventType::GE_Hit, Manager, 0, FVector((float)i, 0.f, 0.f));
+	UE_LOG(StoneStorm, Display, TEXT("Gameplay event recorder: %.1fns per event over %d events"), (FPlatformTime::Seconds() - RecordStart) * 1e9 / Count, Count);
+
+	for (int32 i = 0; i < Manager->Capacity; i++)
+	{
+		if (Manager->State[i] != SS_Free)
+			Manager->KillStone(i);
+	}
+	Manager->DummyCapsules.Reset();
+	Manager->GroundZ = 0.f;
+	if (Manager->CheckPickup())
+	{
+		UE_LOG(StoneStorm, Display, TEXT("Pickup check passed"));
+	}
+	else
+	{
+		UE_LOG(StoneStorm, Error, TEXT("Pickup check failed, a stone resting next to a character could not be picked"));
+	}
+
+	Manager->Destroy();
+}
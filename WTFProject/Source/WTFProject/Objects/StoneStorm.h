@@ -0,0 +1,161 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "StoneStorm.generated.h"
+
+class AWTFProjectCharacter;
+class UPaperSprite;
+class UPaperGroupedSpriteComponent;
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnStormStoneHit, AWTFProjectCharacter* /*HitChar*/, const FVector& /*Location*/);
+
+/**
+ * Simulates large numbers of stones without an actor each, for rain events and multi-stone throws.
+ *
+ * Stones live in structure-of-arrays form and are integrated four at a time with VectorRegister math.
+ * Character capsules are bucketed into a uniform grid every frame so each stone only tests the few
+ * capsules of its own cell. Everything is drawn by a single grouped sprite component.
+ *
+ * Gameplay matches AStone: a flying stone hits the first character that is not its owner once, then
+ * falls with gravity scale 1. Like AStone::CanBePicked it is pickable from its first hit on, falling or
+ * lying on the ground. Stones still moving after MaxFlightTime or leaving the world bounds are removed.
+ *
+ * Trigger from Blueprint through ThrowSpread and SpawnRain, or with wtf.StoneStorm.Rain and
+ * wtf.StoneStorm.Throw around the local player.
+ */
+UCLASS()
+class WTFPROJECT_API AStoneStormManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AStoneStormManager();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	int32 SpawnStone(const FVector& Location, const FVector& Velocity, AWTFProjectCharacter* Owner);
+
+	/** Count stones from Origin towards Direction, spread over SpreadDegrees */
+	UFUNCTION(BlueprintCallable, Category = "Storm")
+	void ThrowSpread(AWTFProjectCharacter* Owner, const FVector& Origin, const FVector& Direction, float Speed, int32 Count, float SpreadDegrees);
+
+	/** Count stones falling from Height over [MinX, MaxX] */
+	UFUNCTION(BlueprintCallable, Category = "Storm")
+	void SpawnRain(int32 Count, float MinX, float MaxX, float Height);
+
+	/** The first rendering manager of the world, or a new one on the floor under Character using its held stone sprite */
+	static AStoneStormManager* FindOrSpawn(UWorld* World, AWTFProjectCharacter* Character);
+
+	/** Removes the closest pickable stone within Radius of Feet, the bottom of the picking capsule; returns whether one was found */
+	bool TryPickStone(const FVector& Feet, float Radius);
+
+	/** TryPickStone on every storm manager of the world */
+	static bool TryPickStoneInWorld(UWorld* World, const FVector& Feet, float Radius);
+
+	/**
+	 * Spawns a non-rendering manager with Count flying stones among NumCapsules dummy character capsules
+	 * and logs the cost of Simulate over Frames steps, then checks a stone landing next to a character can be picked.
+	 */
+	static void RunBenchmark(UWorld* World, int32 Count, int32 Frames, int32 NumCapsules);
+
+	/** Integration, collision and hit dispatch for one step, without touching the render component */
+	void Simulate(float DeltaTime);
+
+	int32 GetNumStones() const { return NumAlive; }
+
+	FOnStormStoneHit OnStoneHit;
+
+	/** Skip the sprite update, used by the benchmark */
+	bool bRender = true;
+
+protected:
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components)
+	UPaperGroupedSpriteComponent* SpriteInstances = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Storm")
+	UPaperSprite* StoneSprite = nullptr;
+
+	/** Stones reserved up front, the pool doubles when it runs out */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Storm")
+	int32 InitialCapacity = 1024;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Storm")
+	float StoneRadius = 12.f;
+
+	/** Gravity scale of a stone before it hits anything, same role as the stone's ProjectileGravityScale */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Storm")
+	float FlyingGravityScale = 0.f;
+
+	/** Stones that have not come to rest after this many seconds are removed */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Storm")
+	float MaxFlightTime = 10.f;
+
+	/** Level collision is approximated by a floor height, stones landing there come to rest */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Storm")
+	float GroundZ = 0.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Storm")
+	float CellSize = 256.f;
+
+	/** Horizontal speed kept (and reversed) when bouncing off a character */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Storm")
+	float Bounciness = 0.3f;
+
+private:
+	enum EStoneState : uint8
+	{
+		SS_Free,
+		SS_Flying,
+		SS_Falling,
+		SS_Resting
+	};
+
+	void Grow(int32 NewCapacity);
+	void Integrate(float DeltaTime);
+	void BuildGrid();
+	void CollideCharacters(float DeltaTime);
+	bool CheckPickup();
+	void UpdateInstances();
+	void KillStone(int32 Index);
+
+	int32 Capacity = 0;
+	int32 NumAlive = 0;
+
+	TArray<float, TAlignedHeapAllocator<16>> PosX;
+	TArray<float, TAlignedHeapAllocator<16>> PosZ;
+	TArray<float, TAlignedHeapAllocator<16>> VelX;
+	TArray<float, TAlignedHeapAllocator<16>> VelZ;
+	TArray<float, TAlignedHeapAllocator<16>> GravityScale;
+	/** 1 while the stone moves, 0 when free or resting, multiplies the integration */
+	TArray<float, TAlignedHeapAllocator<16>> Moving;
+	TArray<float> FlightTime;
+	TArray<uint8> State;
+	TArray<bool> CanDealDamage;
+	TArray<TWeakObjectPtr<AWTFProjectCharacter>> Owner;
+	TArray<int32> FreeList;
+
+	struct FCapsule2D
+	{
+		AWTFProjectCharacter* Character;
+		float X;
+		float Z;
+		float HalfSegment;
+		float Radius;
+	};
+	TArray<FCapsule2D> Capsules;
+	/** Used instead of the world's characters when not empty, Character is null for them */
+	TArray<FCapsule2D> DummyCapsules;
+
+	/** Dense grid over the characters' bounds, each cell a range in CellEntries */
+	int32 GridMinX = 0;
+	int32 GridMinZ = 0;
+	int32 GridSizeX = 0;
+	int32 GridSizeZ = 0;
+	float GridCellSize = 256.f;
+	TArray<int32> CellStart;
+	TArray<int32> CellEntries;
+	TArray<int32> CellCursor;
+};
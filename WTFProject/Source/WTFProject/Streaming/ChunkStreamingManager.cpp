@@ -0,0 +1,199 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ChunkStreamingManager.h"
+#include "WTFProject.h"
+#include "Engine/World.h"
+#include "Engine/LevelStreaming.h"
+#include "Engine/LatentActionManager.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+#include "Kismet/GameplayStatics.h"
+
+DEFINE_LOG_CATEGORY_STATIC(ChunkStreaming, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("Chunk Streaming Update"), STAT_ChunkStreamingUpdate, STATGROUP_WTFProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Chunks Loaded"), STAT_ChunksLoaded, STATGROUP_WTFProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Frames Waiting On Chunk"), STAT_ChunkWaitFrames, STATGROUP_WTFProject);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Last Chunk Load Lead Time (s)"), STAT_ChunkLeadTime, STATGROUP_WTFProject);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Min Chunk Load Lead Time (s)"), STAT_ChunkMinLeadTime, STATGROUP_WTFProject);
+
+AChunkStreamingManager::AChunkStreamingManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+	bReplicates = false;
+}
+
+void AChunkStreamingManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	for (FStreamingChunk& Chunk : Chunks)
+	{
+		if (Chunk.MinX > Chunk.MaxX)
+			Swap(Chunk.MinX, Chunk.MaxX);
+		Chunk.bRequested = false;
+		Chunk.bEntered = false;
+		UpdateChunkState(Chunk);
+		Chunk.bRequested = Chunk.bLoaded;
+	}
+}
+
+void AChunkStreamingManager::GatherPlayers(TArray<float>& OutPositions, TArray<FVector2D>& OutRanges) const
+{
+	UWorld* World = GetWorld();
+	if (!World)
+		return;
+
+	const bool bAllPlayers = World->GetNetMode() != NM_Client;
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PlController = It->Get();
+		if (!PlController || (!bAllPlayers && !PlController->IsLocalController()))
+			continue;
+
+		APawn* Pawn = PlController->GetPawn();
+		if (!Pawn)
+			continue;
+
+		const float X = Pawn->GetActorLocation().X;
+		const float PredictedX = X + Pawn->GetVelocity().X * LookAheadTime;
+		OutPositions.Add(X);
+		OutRanges.Add(FVector2D(FMath::Min(X, PredictedX), FMath::Max(X, PredictedX)));
+	}
+}
+
+bool AChunkStreamingManager::IsChunkWanted(const FStreamingChunk& Chunk, const TArray<FVector2D>& Ranges, float Extra) const
+{
+	for (const FVector2D& Range : Ranges)
+	{
+		if (Chunk.MaxX >= Range.X - Extra && Chunk.MinX <= Range.Y + Extra)
+			return true;
+	}
+	return false;
+}
+
+void AChunkStreamingManager::RequestLoad(FStreamingChunk& Chunk)
+{
+	FLatentActionInfo LatentInfo;
+	LatentInfo.CallbackTarget = this;
+	LatentInfo.UUID = ++NextLatentUUID;
+	LatentInfo.Linkage = 0;
+	UGameplayStatics::LoadStreamLevel(this, Chunk.LevelName, true, false, LatentInfo);
+
+	Chunk.bRequested = true;
+	Chunk.bEntered = false;
+	Chunk.RequestTime = FPlatformTime::Seconds();
+	UE_LOG(ChunkStreaming, Verbose, TEXT("Requested chunk %s"), *Chunk.LevelName.ToString());
+}
+
+void AChunkStreamingManager::RequestUnload(FStreamingChunk& Chunk)
+{
+	FLatentActionInfo LatentInfo;
+	LatentInfo.CallbackTarget = this;
+	LatentInfo.UUID = ++NextLatentUUID;
+	LatentInfo.Linkage = 0;
+	UGameplayStatics::UnloadStreamLevel(this, Chunk.LevelName, LatentInfo);
+
+	Chunk.bRequested = false;
+	UE_LOG(ChunkStreaming, Verbose, TEXT("Released chunk %s"), *Chunk.LevelName.ToString());
+}
+
+void AChunkStreamingManager::UpdateChunkState(FStreamingChunk& Chunk)
+{
+	ULevelStreaming* StreamingLevel = UGameplayStatics::GetStreamingLevel(this, Chunk.LevelName);
+	const bool bWasLoaded = Chunk.bLoaded;
+	Chunk.bLoaded = StreamingLevel && StreamingLevel->IsLevelLoaded();
+	if (Chunk.bLoaded && !bWasLoaded)
+	{
+		Chunk.LoadedTime = FPlatformTime::Seconds();
+		Chunk.bLeadTimeMeasured = false;
+		UE_LOG(ChunkStreaming, Verbose, TEXT("Chunk %s loaded in %.3fs"), *Chunk.LevelName.ToString(), Chunk.LoadedTime - Chunk.RequestTime);
+	}
+}
+
+void AChunkStreamingManager::UpdateStats(const TArray<float>& Positions)
+{
+	const double Now = FPlatformTime::Seconds();
+	for (FStreamingChunk& Chunk : Chunks)
+	{
+		bool bOccupied = false;
+		for (float X : Positions)
+		{
+			if (X >= Chunk.MinX && X <= Chunk.MaxX)
+			{
+				bOccupied = true;
+				break;
+			}
+		}
+
+		if (Chunk.bStalled && (Chunk.bLoaded || !bOccupied))
+		{
+			Chunk.bStalled = false;
+			UE_LOG(ChunkStreaming, Warning, TEXT("Waited %.3fs on chunk %s"), Now - Chunk.StallStartTime, *Chunk.LevelName.ToString());
+		}
+
+		if (!bOccupied)
+		{
+			Chunk.bEntered = false;
+			continue;
+		}
+
+		if (!Chunk.bLoaded)
+		{
+			// A player stands in a chunk whose geometry is not there yet
+			INC_DWORD_STAT(STAT_ChunkWaitFrames);
+			if (!Chunk.bStalled)
+			{
+				Chunk.bStalled = true;
+				Chunk.StallStartTime = Now;
+			}
+		}
+		else if (!Chunk.bEntered)
+		{
+			Chunk.bEntered = true;
+			if (!Chunk.bLeadTimeMeasured)
+			{
+				Chunk.bLeadTimeMeasured = true;
+				LastLeadTime = (float)(Now - Chunk.LoadedTime);
+				MinLeadTime = FMath::Min(MinLeadTime, LastLeadTime);
+			}
+		}
+	}
+
+	SET_FLOAT_STAT(STAT_ChunkLeadTime, LastLeadTime);
+	SET_FLOAT_STAT(STAT_ChunkMinLeadTime, MinLeadTime == MAX_flt ? 0.f : MinLeadTime);
+}
+
+void AChunkStreamingManager::Tick(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ChunkStreamingUpdate);
+	Super::Tick(DeltaSeconds);
+
+	TArray<float> Positions;
+	TArray<FVector2D> Ranges;
+	GatherPlayers(Positions, Ranges);
+
+	// Streaming requests made by the server reach clients through the engine, a client request would fight them
+	const bool bDriveStreaming = GetNetMode() != NM_Client;
+	int32 LoadedCount = 0;
+	for (FStreamingChunk& Chunk : Chunks)
+	{
+		UpdateChunkState(Chunk);
+
+		if (bDriveStreaming && !Chunk.bRequested && IsChunkWanted(Chunk, Ranges, Margin))
+		{
+			RequestLoad(Chunk);
+		}
+		else if (bDriveStreaming && Chunk.bRequested && Ranges.Num() > 0 && !IsChunkWanted(Chunk, Ranges, Margin + UnloadHysteresis))
+		{
+			RequestUnload(Chunk);
+		}
+
+		if (Chunk.bLoaded)
+			LoadedCount++;
+	}
+
+	SET_DWORD_STAT(STAT_ChunksLoaded, LoadedCount);
+	UpdateStats(Positions);
+}
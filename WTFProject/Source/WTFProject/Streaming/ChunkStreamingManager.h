@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ChunkStreamingManager.generated.h"
+
+class ULevelStreaming;
+
+/**
+ * One X-axis slice of a long level, stored as a streaming sublevel of the persistent map.
+ */
+USTRUCT(BlueprintType)
+struct FStreamingChunk
+{
+	GENERATED_BODY()
+
+	/** Package name of the sublevel, as listed in the Levels window */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming")
+	FName LevelName;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming")
+	float MinX = 0.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming")
+	float MaxX = 0.f;
+
+	bool bRequested = false;
+	bool bLoaded = false;
+	double RequestTime = 0.0;
+	double LoadedTime = 0.0;
+	bool bEntered = false;
+	/** Lead time is only measured on the first entry after a load, re-entering a chunk loaded long ago says nothing about streaming */
+	bool bLeadTimeMeasured = false;
+	/** A player is inside the chunk before it finished loading */
+	bool bStalled = false;
+	double StallStartTime = 0.0;
+};
+
+/**
+ * Place one of these in the persistent map. Every tick it predicts where the players will be
+ * LookAheadTime seconds from now (position + GetVelocity().X * LookAheadTime) and asynchronously
+ * loads the chunks covering [current, predicted] +- Margin, unloading chunks nobody is close to.
+ *
+ * On a server (dedicated or listen) the union of every player's range is used, so collision
+ * exists wherever any client is. The server's streaming state is replicated to clients by the
+ * engine, so clients never request loads themselves and only measure lead times and stalls for
+ * their local players.
+ */
+UCLASS()
+class WTFPROJECT_API AChunkStreamingManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AChunkStreamingManager();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+protected:
+	virtual void BeginPlay() override;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming")
+	TArray<FStreamingChunk> Chunks;
+
+	/** How far ahead (in seconds of current velocity) to predict the player position */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming")
+	float LookAheadTime = 2.f;
+
+	/** Extra distance kept loaded around every player range */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming")
+	float Margin = 1024.f;
+
+	/** Chunks are only unloaded once they are this much further than Margin, to avoid thrashing on the border */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming")
+	float UnloadHysteresis = 512.f;
+
+private:
+	void GatherPlayers(TArray<float>& OutPositions, TArray<FVector2D>& OutRanges) const;
+	bool IsChunkWanted(const FStreamingChunk& Chunk, const TArray<FVector2D>& Ranges, float Extra) const;
+	void RequestLoad(FStreamingChunk& Chunk);
+	void RequestUnload(FStreamingChunk& Chunk);
+	void UpdateChunkState(FStreamingChunk& Chunk);
+	void UpdateStats(const TArray<float>& Positions);
+
+	int32 NextLatentUUID = 0;
+
+	float MinLeadTime = MAX_flt;
+	float LastLeadTime = 0.f;
+};
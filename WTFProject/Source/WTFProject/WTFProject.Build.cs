@@ -8,6 +8,6 @@ public class WTFProject : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "Paper2D" });
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "Paper2D", "Sockets", "Networking", "RenderCore", "RHI", "Slate", "SlateCore", "AIModule", "AssetRegistry" });
 	}
 }
@@ -2,5 +2,29 @@
 
 #include "WTFProject.h"
 #include "Modules/ModuleManager.h"
+#include "Debug/GameplayEventRecorder.h"
+#include "Debug/InputLatencyTracker.h"
+#include "Debug/LoadOrderRecorder.h"
+#include "GameplayTuning.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, WTFProject, "WTFProject" );
+class FWTFProjectModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		FGameplayEventRecorder::Startup();
+		FInputLatencyTracker::Startup();
+		FLoadOrderRecorder::Startup();
+		FGameplayTuning::Startup();
+	}
+
+	virtual void ShutdownModule() override
+	{
+		FGameplayTuning::Shutdown();
+		FLoadOrderRecorder::Shutdown();
+		FInputLatencyTracker::Shutdown();
+		FGameplayEventRecorder::Shutdown();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FWTFProjectModule, WTFProject, "WTFProject" );
@@ -3,3 +3,9 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("WTFProject"), STATGROUP_WTFProject, STATCAT_Advanced);
+
+/** Bandwidth counters of thrown stones for wtf.ProjectileNet.Report, compiled out of shipping builds */
+#define WITH_PROJECTILE_NET_STATS !UE_BUILD_SHIPPING
@@ -9,16 +9,56 @@
 #include "GameFramework/Controller.h"
 #include "Engine/World.h"
 #include "Objects/Stone.h"
+#include "Objects/StoneStorm.h"
 #include "GameFramework/PlayerController.h"
 #include "Camera/CameraComponent.h"
+#include "Debug/GameplayEventRecorder.h"
+#include "Debug/InputLatencyTracker.h"
+#include "Camera/SplitscreenCamera.h"
+#include "Net/RollbackManager.h"
+#include "Net/ProjectileStream.h"
+#include "Components/CharacterMovement2D.h"
+#include "GameplayTuning.h"
+#include "GameFramework/GameModeBase.h"
+#include "HAL/IConsoleManager.h"
 
 DEFINE_LOG_CATEGORY_STATIC(SideScrollerCharacter, Log, All);
 
+static FAutoConsoleCommandWithWorldAndArgs CmdCharacterStepCheck(
+	TEXT("wtf.Character.StepCheck"),
+	TEXT("wtf.Character.StepCheck [Seconds=2]: walks a fixed-step character at 30 and 120 fps and compares the distances."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		AWTFProjectCharacter::RunStepCheck(World, Args.Num() > 0 ? FCString::Atof(*Args[0]) : 2.f);
+	}));
+
+namespace CoreEvents = WTFCore::CharacterEvents;
+
+// The rules keep their own copies of the animation enums, the flipbook map is keyed by the engine ones
+static_assert((uint8)EAnimationState::AS_Fall == (uint8)WTFCore::EAnimationState::Fall, "EAnimationState is out of sync with WTFCore");
+static_assert((uint8)EAnimationState::AS_Pick == (uint8)WTFCore::EAnimationState::Pick, "EAnimationState is out of sync with WTFCore");
+static_assert((uint8)ESimpleAnimationState::SAS_Pick == (uint8)WTFCore::ESimpleAnimationState::Pick, "ESimpleAnimationState is out of sync with WTFCore");
+static_assert((uint8)EMovementBlockReason::MBR_Throw == (uint8)WTFCore::EMovementBlockReason::Throw, "EMovementBlockReason is out of sync with WTFCore");
+
+namespace
+{
+	FORCEINLINE WTFCore::FVec2 ToCore(const FVector& Vector)
+	{
+		return WTFCore::FVec2(Vector.X, Vector.Z);
+	}
+
+	FORCEINLINE FVector FromCore(const WTFCore::FVec2& Vector)
+	{
+		return FVector(Vector.X, 0.f, Vector.Z);
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 // AWTFProjectCharacter
 
 //#pragma optimize("", off)
-AWTFProjectCharacter::AWTFProjectCharacter()
+AWTFProjectCharacter::AWTFProjectCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UCharacterMovement2D>(ACharacter::CharacterMovementComponentName))
 {
 	// Use only Yaw from the controller and ignore the rest of the rotation.
 	bUseControllerRotationPitch = false;
@@ -53,14 +93,6 @@ AWTFProjectCharacter::AWTFProjectCharacter()
 	{
 		GetCharacterMovement()->bOrientRotationToMovement = false;
 
-		// Configure character movement
-		GetCharacterMovement()->GravityScale = 2.0f;
-		GetCharacterMovement()->AirControl = 0.80f;
-		GetCharacterMovement()->JumpZVelocity = 1000.f;
-		GetCharacterMovement()->GroundFriction = 3.0f;
-		GetCharacterMovement()->MaxWalkSpeed = 600.0f;
-		GetCharacterMovement()->MaxFlySpeed = 600.0f;
-
 		// Lock character motion onto the XZ plane, so the character can't move in or out of the screen
 		GetCharacterMovement()->bConstrainToPlane = true;
 		GetCharacterMovement()->SetPlaneConstraintNormal(FVector(0.0f, -1.0f, 0.0f));
@@ -80,173 +112,235 @@ AWTFProjectCharacter::AWTFProjectCharacter()
 
 	GetSprite()->OnFinishedPlaying.AddDynamic(this, &AWTFProjectCharacter::UpdateAnimation);
 	GetSprite()->SetLooping(false);
+
+	// Movement and the rules are set up from the tuning in PostInitializeComponents, the CDO keeps the built-in values
+	WTFCore::FCharacterRules::Reset(CoreState, WTFCore::FCharacterTuning());
+}
+
+void AWTFProjectCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// Components are copied from the archetype by now, values written here are not overwritten
+	RefreshTuning();
+	WTFCore::FCharacterRules::Reset(CoreState, Tuning->Character);
+}
+
+void AWTFProjectCharacter::RefreshTuning()
+{
+	const FGameplayTuning& Latest = FGameplayTuning::Get();
+	if (Tuning == &Latest)
+		return;
+
+	Tuning = &Latest;
+	if (UCharacterMovementComponent* Movement = GetCharacterMovement())
+	{
+		Movement->GravityScale = Latest.GravityScale;
+		Movement->AirControl = Latest.AirControl;
+		Movement->JumpZVelocity = Latest.JumpZVelocity;
+		Movement->GroundFriction = Latest.GroundFriction;
+		Movement->MaxWalkSpeed = Latest.MaxWalkSpeed;
+		Movement->MaxFlySpeed = Latest.MaxFlySpeed;
+	}
 }
 
 void AWTFProjectCharacter::Pick()
 {
+	if (CaptureRollbackInput())
+	{
+		RollbackInput.Buttons |= RollbackButtons::Pick;
+		return;
+	}
+
+	BeginLatencySample(TEXT("Pick"), TEXT("Pick"));
 	if (CanPick())
 	{
 		TArray<AActor*> Stones;
 		GetOverlappingActors(Stones, AStone::StaticClass());
-		if (Stones.Num() > 0)
+		bool Picked = false;
+		int i = 0;
+		while (i < Stones.Num() && !Picked)
 		{
-			bool Picked = false;
-			int i = 0;
-			while (i < Stones.Num() && !Picked)
-			{
-				PickStone = Cast<AStone>(Stones[i]);
-				if (PickStone && PickStone->CanBePicked())
-					Picked = true;
-				else
-					i++;
-			}
-			if (Picked)
-			{
-				GetStone();
-				if (GetCharacterMovement())
-					GetCharacterMovement()->StopMovementImmediately();
-				FMovementBlock BlockInfo;
-				BlockInfo.bTimed = true;
-				BlockInfo.Reason = EMovementBlockReason::MBR_Pick;
-				BlockInfo.Time = 0.6f;
-				AddMovementBlock(BlockInfo);
-				SetAnimationState(ESimpleAnimationState::SAS_Pick);
-			}
+			PickStone = Cast<AStone>(Stones[i]);
+			if (PickStone && PickStone->CanBePicked())
+				Picked = true;
+			else
+				i++;
+		}
+		// Resting storm stones lie on the floor, far below the capsule center
+		const FVector Feet = GetActorLocation() - FVector(0.f, 0.f, GetCapsuleComponent()->GetScaledCapsuleHalfHeight());
+		if (!Picked && !RollbackManager && AStoneStormManager::TryPickStoneInWorld(GetWorld(), Feet, GetCapsuleComponent()->GetScaledCapsuleRadius() * 2.f))
+		{
+			// Storm stones have no actor, the manager already removed the picked one
+			PickStone = nullptr;
+			Picked = true;
+		}
+		if (Picked)
+		{
+			FinishPick();
+			return;
 		}
 	}
+	CancelLatencySample();
 }
 
-bool AWTFProjectCharacter::CanPick()
+void AWTFProjectCharacter::FinishPick()
 {
-	return !GetCharacterMovement() || !GetCharacterMovement()->IsFalling();
+	if (PickStone)
+	{
+		if (RollbackManager)
+			RollbackManager->ReleaseStone(PickStone);
+		else
+			PickStone->Destroy();
+		PickStone = nullptr;
+	}
+
+	WTFCore::FCharacterEvents Events;
+	WTFCore::FCharacterRules::PickStone(CoreState, MakeCoreContext(), Tuning->Character, Events);
+	ApplyCoreEvents(Events);
+	FGameplayEventRecorder::Record(EGameplayEventType::GE_Pick, this, (uint8)CoreState.Ammo, GetActorLocation());
 }
 
-void AWTFProjectCharacter::GetStone()
+void AWTFProjectCharacter::StopPick()
 {
-	if (PickStone)
-		PickStone->Destroy();
-
-	if (Ammo == 0)
-		AttachStone();
+	if (CaptureRollbackInput())
+		RollbackInput.Buttons &= ~RollbackButtons::Pick;
+}
 
-	Ammo++;
+bool AWTFProjectCharacter::CanPick()
+{
+	return WTFCore::FCharacterRules::CanPick(CoreState, MakeCoreContext());
 }
 
 bool AWTFProjectCharacter::CanThrow()
 {
-	bool Res = !GetCharacterMovement() || !GetCharacterMovement()->IsFalling();
-	Res &= Ammo > 0;
-	Res &= !bThrowing;
-	Res &= bIsAiming;
-	return Res;
+	return WTFCore::FCharacterRules::CanThrow(CoreState, MakeCoreContext());
 }
 
 void AWTFProjectCharacter::Throw()
 {
+	if (CaptureRollbackInput())
+	{
+		RollbackInput.Buttons &= ~RollbackButtons::Throw;
+		return;
+	}
+
+	BeginLatencySample(TEXT("Throw"), TEXT("Throw"));
 	if (CanThrow())
 	{
-		ThrowDirection = GetViewDirection();
-		if (GetCharacterMovement())
-			GetCharacterMovement()->StopMovementImmediately();
-		bThrowing = true;
-		StopAim();
-		FMovementBlock BlockInfo;
-		BlockInfo.Reason = EMovementBlockReason::MBR_Throw;
-		BlockInfo.bTimed = true;
-		BlockInfo.Time = ThrowTimer;
-		ThrowTimerCurrent = ThrowTimer;
-		AddMovementBlock(BlockInfo);
-		SetAnimationState(ESimpleAnimationState::SAS_Throw);
+		// Rollback input and bots set the aim directly
+		const FVector Direction = (RollbackManager || !IsPlayerControlled()) ? FromCore(CoreState.AimDirection) : GetViewDirection();
+		WTFCore::FCharacterEvents Events;
+		WTFCore::FCharacterRules::Throw(CoreState, MakeCoreContext(), Tuning->Character, ToCore(Direction), Events);
+		ApplyCoreEvents(Events);
+	}
+	else
+	{
+		CancelLatencySample();
 	}
 }
 
-void AWTFProjectCharacter::StopThrow()
+void AWTFProjectCharacter::LaunchStone()
 {
-	bThrowing = false;
 	UWorld* World = GetWorld();
-	if (World && StoneClass)
-	{
-		FActorSpawnParameters Params;
-		Params.Instigator = this;
-		FRotator Rotation = ThrowDirection.Rotation();
-		FVector Location = GetActorLocation() + StoneSpawnLocation;
-		Ammo--;
-		if (Ammo == 0)
-			DetachStone();
+	FActorSpawnParameters Params;
+	Params.Instigator = this;
+	const FVector ThrowDirection = FromCore(CoreState.ThrowDirection);
+	FRotator Rotation = ThrowDirection.Rotation();
+	FVector Location = GetActorLocation() + StoneSpawnLocation;
+	FGameplayEventRecorder::Record(EGameplayEventType::GE_Throw, this, (uint8)CoreState.Ammo, Location);
+	if (RollbackManager)
+		RollbackManager->LaunchStone(this, Location, ThrowDirection);
+	else if (AProjectileStream::IsEnabled(World))
+		AProjectileStream::Get(World)->Throw(this, StoneClass, Location, ThrowDirection);
+	else
+	{
 		World->SpawnActor(StoneClass, &Location, &Rotation, Params);
+#if WITH_PROJECTILE_NET_STATS
+		if (GetNetMode() == NM_ListenServer || GetNetMode() == NM_DedicatedServer)
+			FProjectileNetStats::ActorThrows++;
+#endif
 	}
 }
 
 void AWTFProjectCharacter::Aim()
 {
-	if (CanAim())
+	if (CaptureRollbackInput())
 	{
-		bIsAiming = true;
-		/*FMovementBlock BlockInfo;
-		BlockInfo.Reason = EMovementBlockReason::MBR_Aim;
-		BlockInfo.bTimed = false;
-		AddMovementBlock(BlockInfo);*/
+		RollbackInput.Buttons |= RollbackButtons::Throw;
+		return;
 	}
+
+	BeginLatencySample(TEXT("Aim"), TEXT("Throw"));
+	if (!CanAim())
+		CancelLatencySample();
+	WTFCore::FCharacterRules::Aim(CoreState, MakeCoreContext());
 }
 
 void AWTFProjectCharacter::StopAim()
 {
-	bIsAiming = false;
-	//RemoveSpecificMovementBlock(EMovementBlockReason::MBR_Aim);
+	WTFCore::FCharacterRules::StopAim(CoreState);
 }
 
 bool AWTFProjectCharacter::IsAiming()
 {
-	return bIsAiming;
+	return CoreState.bIsAiming;
 }
 
 bool AWTFProjectCharacter::CanAim()
 {
-	bool Res = !GetCharacterMovement() || !GetCharacterMovement()->IsFalling();
-	Res &= Ammo > 0 && !bThrowing;
-	return Res;
+	return WTFCore::FCharacterRules::CanAim(CoreState, MakeCoreContext());
 }
 
 void AWTFProjectCharacter::CharJump()
 {
-	if (CanMove() && GetCharacterMovement() && !GetCharacterMovement()->IsFalling())
+	if (CaptureRollbackInput())
 	{
-		Jump();
-		SetAnimationState(ESimpleAnimationState::SAS_Jump);
+		RollbackInput.Buttons |= RollbackButtons::Jump;
+		return;
 	}
-}
 
-void AWTFProjectCharacter::AddMovementBlock(FMovementBlock BlockInfo)
-{
-	int i = 0;
-	bool Added = false;
-	while (i < MovementBlocks.Num() && !Added)
+	BeginLatencySample(TEXT("Jump"), TEXT("Jump"));
+	const WTFCore::FCharacterContext Context = MakeCoreContext();
+	if (GetCharacterMovement() && WTFCore::FCharacterRules::CanJump(CoreState, Context))
 	{
-		if (MovementBlocks[i].Reason == BlockInfo.Reason)
-		{
-			MovementBlocks[i] = BlockInfo;
-			Added = true;
-		}
-		else
-			i++;
+		WTFCore::FCharacterEvents Events;
+		WTFCore::FCharacterRules::Jump(CoreState, Context, Tuning->Character, Events);
+		ApplyCoreEvents(Events);
+		bStepJumpHeld = true;
 	}
+	else
+	{
+		CancelLatencySample();
+	}
+}
+
+void AWTFProjectCharacter::BeginLatencySample(const TCHAR* Action, FName InputAction)
+{
+	// A sample still pending was superseded by this input
+	CancelLatencySample();
+
+	// Only a local human has an input event to measure from, bots and remote players would add made-up samples
+	if (IsLocallyControlled() && IsPlayerControlled())
+		PendingLatencySample = FInputLatencyTracker::BeginSample(Action, InputAction);
+}
 
-	if (!Added)
-		MovementBlocks.Add(BlockInfo);
+void AWTFProjectCharacter::CancelLatencySample()
+{
+	FInputLatencyTracker::CancelSample(PendingLatencySample);
+	PendingLatencySample = FInputLatencyTracker::InvalidSample;
 }
 
-void AWTFProjectCharacter::RemoveSpecificMovementBlock(EMovementBlockReason Block)
+void AWTFProjectCharacter::CharStopJumping()
 {
-	int i = 0;
-	while (i < MovementBlocks.Num())
+	if (CaptureRollbackInput())
 	{
-		if (MovementBlocks[i].Reason == Block)
-		{
-			MovementBlocks.RemoveAt(i);
-		}
-		else
-			i++;
+		RollbackInput.Buttons &= ~RollbackButtons::Jump;
+		return;
 	}
+
+	bStepJumpHeld = false;
+	StopJumping();
 }
 
 void AWTFProjectCharacter::AttachStone()
@@ -275,228 +369,110 @@ FVector AWTFProjectCharacter::GetViewDirection() const
 
 void AWTFProjectCharacter::SetCharacterDirectionRight(bool IsRight)
 {
-	APlayerController* PlController = Cast<APlayerController>(GetController());
-	if (PlController)
+	if (RollbackManager)
+	{
+		// Facing is part of the simulated state, so it can't come from the controller
+		FVector NewLocation = StoneSpriteComponent->RelativeLocation;
+		NewLocation.Y = IsRight ? 1.f : -1.f;
+		StoneSpriteComponent->SetRelativeLocation(NewLocation);
+		SetActorRotation(FRotator(0.0f, IsRight ? 0.0f : 180.0f, 0.0f));
+		return;
+	}
+
+	AController* Controller = GetController();
+	if (Controller)
 	{
 		if (IsRight)
 		{
 			FVector NewLocation = StoneSpriteComponent->RelativeLocation;
 			NewLocation.Y = 1.f;
 			StoneSpriteComponent->SetRelativeLocation(NewLocation);
-			PlController->SetControlRotation(FRotator(0.0f, 0.0f, 0.0f));
+			Controller->SetControlRotation(FRotator(0.0f, 0.0f, 0.0f));
 		}
 		else
 		{
 			FVector NewLocation = StoneSpriteComponent->RelativeLocation;
 			NewLocation.Y = -1.f;
 			StoneSpriteComponent->SetRelativeLocation(NewLocation);
-			PlController->SetControlRotation(FRotator(0.0, 180.0f, 0.0f));
+			Controller->SetControlRotation(FRotator(0.0, 180.0f, 0.0f));
 		}
 	}
-	
+
 }
 
 
 bool AWTFProjectCharacter::CanMove() const
 {
-	bool Res = true;
-	if (MovementBlocks.Num() > 0)
-		Res = false;
-	return Res;
+	return WTFCore::FCharacterRules::CanMove(CoreState);
 }
 
 void AWTFProjectCharacter::UpdateMovementBlocks(float DeltaTime)
 {
-	int i = 0;
-	bool RemoveCurrent;
-	while (i < MovementBlocks.Num())
-	{
-		RemoveCurrent = false;
-		if (MovementBlocks[i].bTimed)
-		{
-			MovementBlocks[i].Time -= DeltaTime;
-			if (MovementBlocks[i].Time <= 0.f)
-				RemoveCurrent = true;
-		}
-		if (RemoveCurrent)
-			MovementBlocks.RemoveAt(i);
-		else
-			i++;
-	}
+	WTFCore::FCharacterEvents Events;
+	WTFCore::FCharacterRules::UpdateMovementBlocks(CoreState, DeltaTime, Events);
+	ApplyCoreEvents(Events);
 }
 
-void AWTFProjectCharacter::UpdateAnimationState()
+WTFCore::FCharacterContext AWTFProjectCharacter::MakeCoreContext() const
 {
-	const FVector PlayerVelocity = GetVelocity();
-	const float PlayerSpeedSqr = PlayerVelocity.SizeSquared();
-	if (bIsAiming)
-	{
-		SetAnimationState(ESimpleAnimationState::SAS_Aim);
-	}
-	else if (PlayerSpeedSqr > 0.0f)
-	{
-		if (GetCharacterMovement() && GetCharacterMovement()->IsFalling())
-		{
-			SetAnimationState(ESimpleAnimationState::SAS_Fall);
-		}
-		else
-			SetAnimationState(ESimpleAnimationState::SAS_Walk);
-	}
-	else
-	{
-		SetAnimationState(ESimpleAnimationState::SAS_Idle);
-	}
+	WTFCore::FCharacterContext Context;
+	Context.Velocity = ToCore(GetVelocity());
+	Context.Forward = ToCore(GetActorForwardVector());
+	Context.bFalling = GetCharacterMovement() && GetCharacterMovement()->IsFalling();
+	Context.bControlsFacing = RollbackManager || GetController();
+	Context.bCanLaunchStone = GetWorld() && StoneClass;
+	return Context;
 }
 
-void AWTFProjectCharacter::SetAnimationState(ESimpleAnimationState NewState)
+void AWTFProjectCharacter::ApplyCoreEvents(const WTFCore::FCharacterEvents& Events)
 {
-	EAnimationState OldState = CurrentAnimationState;
-	bool SetReverse = false;
-	bool SameFrame = false;
-	switch (NewState)
-	{
-	case ESimpleAnimationState::SAS_Idle:
-	{
-		if (CurrentAnimationState != EAnimationState::AS_ThrowUp &&
-			CurrentAnimationState != EAnimationState::AS_ThrowFront &&
-			CurrentAnimationState != EAnimationState::AS_ThrowDown &&
-			CurrentAnimationState != EAnimationState::AS_Pick &&
-			CurrentAnimationState != EAnimationState::AS_Hit)
-		{
-			if (Ammo > 0)
-				CurrentAnimationState = EAnimationState::AS_CarryIdle;
-			else
-				CurrentAnimationState = EAnimationState::AS_Idle;
-		}
-		break;
-	}
-	case ESimpleAnimationState::SAS_Fall:
-	{
-		if (CurrentAnimationState != EAnimationState::AS_Jump && CurrentAnimationState != EAnimationState::AS_CarryJump)
-		{
-			if (Ammo > 0)
-			{
-				CurrentAnimationState = EAnimationState::AS_CarryFall;
-			}
-			else
-			{
-				CurrentAnimationState = EAnimationState::AS_Fall;
-			}
-		}
-		break;
-	}
-	case ESimpleAnimationState::SAS_Aim:
-	{
-		const FVector PlayerVelocity = GetVelocity();
-		bool AimWalkSameSide = true;
-		float VelocityXSign = FMath::Sign(PlayerVelocity.X);
-		if (!FMath::IsNearlyZero(VelocityXSign) && (VelocityXSign != FMath::Sign(AimDirection.X)))
-			AimWalkSameSide = false;
-		if (AimWalkSameSide && bIsReversing)
-		{
-			bIsReversing = false;
-			GetSprite()->Play();
-		}
-		else if (!AimWalkSameSide && !bIsReversing)
-		{
-			bIsReversing = true;
-			SetReverse = true;
-			GetSprite()->Reverse();
-		}
+	if (Events.Has(CoreEvents::StopMovement) && GetCharacterMovement())
+		GetCharacterMovement()->StopMovementImmediately();
+	if (Events.Has(CoreEvents::Jump))
+		ACharacter::Jump();
 
-		const float PlayerSpeedSqr = PlayerVelocity.SizeSquared();
-		float AimAngle = FMath::UnwindDegrees(FMath::RadiansToDegrees(acosf(FVector::DotProduct(GetActorForwardVector(), AimDirection)))) * FMath::Sign(AimDirection.Z);
-		if (AimAngle > 30.f)
-		{
-			if (PlayerSpeedSqr > 0.0f)
-			{
-				SameFrame = true;
-				CurrentAnimationState = EAnimationState::AS_WalkAimingUp;
-			}
-			else
-			{
-				CurrentAnimationState = EAnimationState::AS_AimingUp;
-			}
-		}
-		else if (AimAngle < -30.f)
-		{
-			if (PlayerSpeedSqr > 0.0f)
-			{
-				SameFrame = true;
-				CurrentAnimationState = EAnimationState::AS_WalkAimingDown;
-			}
-			else
-			{
-				CurrentAnimationState = EAnimationState::AS_AimingDown;
-			}
-		}
-		else
-		{
-			if (PlayerSpeedSqr > 0.0f)
-			{
-				SameFrame = true;
-				CurrentAnimationState = EAnimationState::AS_WalkAimingFront;
-			}
-			else
-			{
-				CurrentAnimationState = EAnimationState::AS_AimingFront;
-			}
-		}
-		break;
-	}
-	case ESimpleAnimationState::SAS_Jump:
-	{
-		if (Ammo > 0)
-			CurrentAnimationState = EAnimationState::AS_CarryJump;
-		else
-			CurrentAnimationState = EAnimationState::AS_Jump;
-		break;
-	}
-	case ESimpleAnimationState::SAS_Pick:
-	{
-		CurrentAnimationState = EAnimationState::AS_Pick;
-		break;
-	}
-	case ESimpleAnimationState::SAS_Throw:
-	{
-		float AimAngle = FMath::UnwindDegrees(FMath::RadiansToDegrees(acosf(FVector::DotProduct(GetActorForwardVector(), AimDirection)))) * FMath::Sign(AimDirection.Z);
-		if (AimAngle > 30.f)
-		{
-			CurrentAnimationState = EAnimationState::AS_ThrowUp;
-		}
-		else if (AimAngle < -30.f)
-		{
-			CurrentAnimationState = EAnimationState::AS_ThrowDown;
-		}
-		else
-		{
-			CurrentAnimationState = EAnimationState::AS_ThrowFront;
-		}
-		break;
-	}
-	case ESimpleAnimationState::SAS_Walk:
+	if (Events.Has(CoreEvents::AttachStone))
+		AttachStone();
+	if (Events.Has(CoreEvents::DetachStone))
+		DetachStone();
+	if (Events.Has(CoreEvents::LaunchStone))
+		LaunchStone();
+
+	for (uint8 Reason = 0; Reason < (uint8)WTFCore::EMovementBlockReason::Count; Reason++)
 	{
-		if (Ammo > 0)
-			CurrentAnimationState = EAnimationState::AS_CarryWalk;
-		else
-			CurrentAnimationState = EAnimationState::AS_Walk;
-		break;
-	}
+		if (Events.BlocksAdded & (1 << Reason))
+			FGameplayEventRecorder::Record(EGameplayEventType::GE_MovementBlockAdded, this, Reason, GetActorLocation());
+		if (Events.BlocksRemoved & (1 << Reason))
+			FGameplayEventRecorder::Record(EGameplayEventType::GE_MovementBlockRemoved, this, Reason, GetActorLocation());
 	}
-	
-	if (OldState != CurrentAnimationState)
+
+	if (Events.Has(CoreEvents::FacingChanged))
+		SetCharacterDirectionRight(CoreState.bFacingRight);
+
+	if (Events.Has(CoreEvents::PlayForward))
+		GetSprite()->Play();
+	if (Events.Has(CoreEvents::PlayReverse))
+		GetSprite()->Reverse();
+
+	if (Events.Has(CoreEvents::AnimationChanged))
 	{
-		if (bIsReversing && !SetReverse)
+		FGameplayEventRecorder::Record(EGameplayEventType::GE_AnimationState, this, (uint8)CoreState.AnimationState, GetActorLocation());
+		UpdateFlipbook(Events.Has(CoreEvents::SameFrame));
+
+		// Stays pending over steps without a change, the tracker times it out if none comes
+		if (PendingLatencySample != FInputLatencyTracker::InvalidSample)
 		{
-			bIsReversing = false;
-			GetSprite()->Play();
+			FInputLatencyTracker::MarkGameThread(PendingLatencySample);
+			PendingLatencySample = FInputLatencyTracker::InvalidSample;
 		}
-		UpdateFlipbook(SameFrame);
 	}
+	else if (Events.Has(CoreEvents::RestartFlipbook))
+		UpdateFlipbook(false);
 }
 
 void AWTFProjectCharacter::UpdateFlipbook(bool SameFrame)
 {
+	const EAnimationState CurrentAnimationState = GetAnimationState();
 	float CurrentTime = GetSprite()->GetPlaybackPosition();
 	if (AnimationStates.Contains(CurrentAnimationState) && AnimationStates[CurrentAnimationState].Animations.Num() > 0)
 	{
@@ -508,14 +484,14 @@ void AWTFProjectCharacter::UpdateFlipbook(bool SameFrame)
 	if (SameFrame && GetSprite()->GetFlipbookLength() >= CurrentTime)
 	{
 		GetSprite()->SetPlaybackPosition(CurrentTime, false);
-		if (bIsReversing)
+		if (CoreState.bIsReversing)
 			GetSprite()->Reverse();
 		else
 			GetSprite()->Play();
 	}
 	else
 	{
-		if (bIsReversing)
+		if (CoreState.bIsReversing)
 		{
 			GetSprite()->ReverseFromEnd();
 		}
@@ -528,37 +504,163 @@ void AWTFProjectCharacter::UpdateFlipbook(bool SameFrame)
 
 void AWTFProjectCharacter::UpdateAnimation()
 {
-	bool SameFrame = false;
-	if (CurrentAnimationState == EAnimationState::AS_ThrowUp ||
-		CurrentAnimationState == EAnimationState::AS_ThrowFront ||
-		CurrentAnimationState == EAnimationState::AS_ThrowDown ||
-		CurrentAnimationState == EAnimationState::AS_Pick ||
-		CurrentAnimationState == EAnimationState::AS_Hit)
+	WTFCore::FCharacterEvents Events;
+	WTFCore::FCharacterRules::FinishAnimation(CoreState, MakeCoreContext(), Tuning->Character, Events);
+
+	// The animation that follows the end of another one was not caused by the pending input
+	const uint32 LatencySample = PendingLatencySample;
+	PendingLatencySample = FInputLatencyTracker::InvalidSample;
+	ApplyCoreEvents(Events);
+	PendingLatencySample = LatencySample;
+}
+
+void AWTFProjectCharacter::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+	RefreshTuning();
+
+	// Stepped by ARollbackManager::SimulateFrame instead
+	if (RollbackManager)
+		return;
+
+	if (bFixedStepSimulation && FixedStepRate > 0.f)
 	{
-		//?   ?
-		CurrentAnimationState = EAnimationState::AS_Walk;
-		SetAnimationState(ESimpleAnimationState::SAS_Idle);
+		// Remote characters keep the engine's movement replication and smoothing, only their gameplay is stepped
+		SetMovementStepped(IsLocallyControlled() || GetNetMode() == NM_Standalone);
+
+		const float StepTime = 1.f / FixedStepRate;
+		StepAccumulator += DeltaSeconds;
+
+		int Steps = 0;
+		while (StepAccumulator >= StepTime && Steps < MaxStepsPerFrame)
+		{
+			StepGameplay(StepTime);
+			StepAccumulator -= StepTime;
+			Steps++;
+		}
+
+		// Still behind after the allowed amount of work: drop the backlog instead of spiralling
+		if (StepAccumulator >= StepTime)
+			StepAccumulator = FMath::Fmod(StepAccumulator, StepTime);
+
+		if (bMovementStepped)
+			UpdateInterpolation(StepAccumulator / StepTime);
 	}
-	else if (CurrentAnimationState == EAnimationState::AS_Jump || CurrentAnimationState == EAnimationState::AS_CarryJump)
+	else
 	{
-		//?   ?
-		CurrentAnimationState = EAnimationState::AS_Walk;
-		SetAnimationState(ESimpleAnimationState::SAS_Fall);
+		SetMovementStepped(false);
+		UpdateMovementBlocks(DeltaSeconds);
+		UpdateCharacter(DeltaSeconds);
 	}
-	else if (CurrentAnimationState != EAnimationState::AS_AimingDown &&
-			 CurrentAnimationState != EAnimationState::AS_AimingFront &&
-			 CurrentAnimationState != EAnimationState::AS_AimingUp)
+}
+
+void AWTFProjectCharacter::StepGameplay(float StepTime)
+{
+	UpdateMovementBlocks(StepTime);
+	UpdateCharacter(StepTime);
+
+	if (bMovementStepped && GetCharacterMovement())
 	{
-		UpdateFlipbook(SameFrame);
+		// Input arrives once per frame but every movement tick consumes it, without this only the first step of a frame would walk
+		if (CanMove())
+			AddMovementInput(FVector(1.0f, 0.0f, 0.0f), StepMoveAxis);
+		// A held jump keeps its extra height for the same number of steps at any frame rate, a landed one is not repeated
+		if (bStepJumpHeld && JumpCurrentCount > 0 && JumpKeyHoldTime < GetJumpMaxHoldTime())
+			bPressedJump = true;
+
+		PreviousStepLocation = GetActorLocation();
+		GetCharacterMovement()->TickComponent(StepTime, LEVELTICK_All, nullptr);
+		CurrentStepLocation = GetActorLocation();
 	}
 }
 
-void AWTFProjectCharacter::Tick(float DeltaSeconds)
+void AWTFProjectCharacter::SetMovementStepped(bool bStepped)
 {
-	Super::Tick(DeltaSeconds);
+	if (bMovementStepped == bStepped)
+		return;
+
+	bMovementStepped = bStepped;
+	if (GetCharacterMovement())
+		GetCharacterMovement()->SetComponentTickEnabled(!bStepped);
+
+	// Start from where the capsule is, this also puts the sprite and camera back on it
+	PreviousStepLocation = CurrentStepLocation = GetActorLocation();
+	UpdateInterpolation(1.f);
+}
+
+void AWTFProjectCharacter::UpdateInterpolation(float Alpha)
+{
+	// Capsule moves once per step, sprite and camera follow it interpolated between the last two steps
+	const FVector VisualLocation = FMath::Lerp(PreviousStepLocation, CurrentStepLocation, FMath::Clamp(Alpha, 0.f, 1.f));
+	const FVector Offset = GetActorTransform().InverseTransformVectorNoScale(VisualLocation - GetActorLocation());
+
+	if (GetSprite())
+		GetSprite()->SetRelativeLocation(SpriteBaseLocation + Offset);
+	CameraBoom->SetRelativeLocation(CameraBoomBaseLocation + Offset);
+}
+
+bool AWTFProjectCharacter::RunStepCheck(UWorld* World, float Seconds)
+{
+	AGameModeBase* GameMode = World ? World->GetAuthGameMode() : nullptr;
+	if (!GameMode || Seconds <= 0.f)
+	{
+		UE_LOG(SideScrollerCharacter, Warning, TEXT("The step check needs a world with a game mode, run it in a standalone game"));
+		return false;
+	}
 
-	UpdateMovementBlocks(DeltaSeconds);
-	UpdateCharacter(DeltaSeconds);
+	UClass* CharacterClass = GameMode->DefaultPawnClass;
+	if (!CharacterClass || !CharacterClass->IsChildOf(AWTFProjectCharacter::StaticClass()))
+		CharacterClass = AWTFProjectCharacter::StaticClass();
+	AActor* PlayerStart = GameMode->FindPlayerStart(nullptr);
+	const FTransform Start = PlayerStart ? PlayerStart->GetActorTransform() : FTransform::Identity;
+
+	FActorSpawnParameters Params;
+	Params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	const float FrameRates[] = { 30.f, 120.f };
+	float Distances[2] = {};
+	float StepDistance = 0.f;
+	for (int32 Run = 0; Run < 2; Run++)
+	{
+		AWTFProjectCharacter* Character = World->SpawnActor<AWTFProjectCharacter>(CharacterClass, Start, Params);
+		if (!Character)
+			return false;
+
+		// Ticked here instead of by the world, frame by frame as a game at that frame rate would
+		Character->SetActorTickEnabled(false);
+		Character->bFixedStepSimulation = true;
+		Character->GetCharacterMovement()->bRunPhysicsWithNoController = true;
+		StepDistance = Character->GetCharacterMovement()->MaxWalkSpeed / Character->FixedStepRate;
+
+		// Land first, the walk starts standing still
+		for (int32 Frame = 0; Frame < 60; Frame++)
+		{
+			Character->MoveRight(0.f);
+			Character->Tick(1.f / 60.f);
+		}
+
+		const float StartX = Character->GetActorLocation().X;
+		const int32 Frames = FMath::RoundToInt(Seconds * FrameRates[Run]);
+		for (int32 Frame = 0; Frame < Frames; Frame++)
+		{
+			Character->MoveRight(1.f);
+			Character->Tick(1.f / FrameRates[Run]);
+		}
+		Distances[Run] = Character->GetActorLocation().X - StartX;
+		Character->Destroy();
+	}
+
+	// The accumulator may leave the last step for the next frame at one of the rates
+	const bool bPassed = FMath::Abs(Distances[0] - Distances[1]) <= StepDistance + 1.f;
+	if (bPassed)
+	{
+		UE_LOG(SideScrollerCharacter, Display, TEXT("Step check passed: %.1f at 30 fps, %.1f at 120 fps over %.1fs"), Distances[0], Distances[1], Seconds);
+	}
+	else
+	{
+		UE_LOG(SideScrollerCharacter, Warning, TEXT("Step check failed: %.1f at 30 fps, %.1f at 120 fps over %.1fs"), Distances[0], Distances[1], Seconds);
+	}
+	return bPassed;
 }
 
 void AWTFProjectCharacter::BeginPlay()
@@ -567,11 +669,19 @@ void AWTFProjectCharacter::BeginPlay()
 	if (GetSprite())
 		GetSprite()->PlayFromStart();
 
-	if (Ammo > 0)
+	if (CoreState.Ammo > 0)
 	{
 		AttachStone();
 	}
-	MovementBlocks.Empty();
+	CoreState.NumMovementBlocks = 0;
+
+	if (GetSprite())
+		SpriteBaseLocation = GetSprite()->RelativeLocation;
+	CameraBoomBaseLocation = CameraBoom->RelativeLocation;
+	PreviousStepLocation = CurrentStepLocation = GetActorLocation();
+	StepAccumulator = 0.f;
+
+	ASplitscreenCamera::EnsureForWorld(GetWorld());
 }
 
 
@@ -588,10 +698,11 @@ void AWTFProjectCharacter::SetupPlayerInputComponent(class UInputComponent* Play
 	}
 
 	PlayerInputComponent->BindAction("Jump", IE_Pressed, this, &AWTFProjectCharacter::CharJump);
-	PlayerInputComponent->BindAction("Jump", IE_Released, this, &ACharacter::StopJumping);
+	PlayerInputComponent->BindAction("Jump", IE_Released, this, &AWTFProjectCharacter::CharStopJumping);
 	PlayerInputComponent->BindAction("Throw", IE_Pressed, this, &AWTFProjectCharacter::Aim);
 	PlayerInputComponent->BindAction("Throw", IE_Released, this, &AWTFProjectCharacter::Throw);
 	PlayerInputComponent->BindAction("Pick", IE_Pressed, this, &AWTFProjectCharacter::Pick);
+	PlayerInputComponent->BindAction("Pick", IE_Released, this, &AWTFProjectCharacter::StopPick);
 	PlayerInputComponent->BindAxis("MoveRight", this, &AWTFProjectCharacter::MoveRight);
 
 	PlayerInputComponent->BindTouch(IE_Pressed, this, &AWTFProjectCharacter::TouchStarted);
@@ -602,6 +713,17 @@ void AWTFProjectCharacter::MoveRight(float Value)
 {
 	/*UpdateChar();*/
 
+	if (CaptureRollbackInput())
+	{
+		RollbackInput.SetMoveAxis(Value);
+		return;
+	}
+
+	// Stepped movement applies it once per step instead
+	StepMoveAxis = Value;
+	if (bMovementStepped)
+		return;
+
 	// Apply the input to the character motion
 	if (CanMove())
 		AddMovementInput(FVector(1.0f, 0.0f, 0.0f), Value);
@@ -610,7 +732,7 @@ void AWTFProjectCharacter::MoveRight(float Value)
 void AWTFProjectCharacter::TouchStarted(const ETouchIndex::Type FingerIndex, const FVector Location)
 {
 	// Jump on any touch
-	if (CanMove())
+	if (CanMove() && !RollbackManager)
 	{
 		Jump();
 	}
@@ -624,54 +746,100 @@ void AWTFProjectCharacter::TouchStopped(const ETouchIndex::Type FingerIndex, con
 
 void AWTFProjectCharacter::UpdateCharacter(float DeltaSeconds)
 {
+	WTFCore::FCharacterContext Context = MakeCoreContext();
 
-	const FVector PlayerVelocity = GetVelocity();	
-	float TravelDirection = PlayerVelocity.X;
-
-	if (IsAiming() && !CanAim())
-	{
-		StopAim();
-	}
-
-	if (bThrowing)
+	// Rollback sessions replay the aim from the input instead
+	APlayerController* PlController = Cast<APlayerController>(GetController());
+	if (PlController && !RollbackManager && IsAiming() && WTFCore::FCharacterRules::CanAim(CoreState, Context))
 	{
-		ThrowTimerCurrent -= DeltaSeconds;
-		if (ThrowTimerCurrent <= 0.f)
+		FVector Direction;
+		FVector Location;
+		Context.bAimValid = PlController->DeprojectMousePositionToWorld(Location, Direction);
+		if (Context.bAimValid)
 		{
-			StopThrow();
+			Location.Y = 0.f;
+			CoreState.AimDirection = ToCore((Location - GetActorLocation()).GetSafeNormal());
 		}
 	}
 
-	APlayerController* PlController = Cast<APlayerController>(GetController());
-	if (PlController)
+	WTFCore::FCharacterEvents Events;
+	WTFCore::FCharacterRules::Update(CoreState, Context, Tuning->Character, DeltaSeconds, Events);
+	ApplyCoreEvents(Events);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Rollback
+
+void AWTFProjectCharacter::EnableRollback(ARollbackManager* Manager)
+{
+	RollbackManager = Manager;
+	bUseControllerRotationYaw = false;
+	if (GetCharacterMovement())
 	{
-		if (IsAiming())
-		{
-			FVector Direction;
-			FVector Location;
-			if (PlController->DeprojectMousePositionToWorld(Location, Direction))
-			{
-				Location.Y = 0.f;
-				AimDirection = (Location - GetActorLocation()).GetSafeNormal();
-				if (AimDirection.X >= 0)
-				{
-					SetCharacterDirectionRight(true);
-				}
-				else
-				{
-					SetCharacterDirectionRight(false);
-				}
-			}
-		}
-		else if (TravelDirection < 0.0f)
-		{
-			SetCharacterDirectionRight(false);
-		}
-		else if (TravelDirection > 0.0f)
-		{
-			SetCharacterDirectionRight(true);
-		}
+		GetCharacterMovement()->SetComponentTickEnabled(false);
+		GetCharacterMovement()->bRunPhysicsWithNoController = true;
 	}
-	UpdateAnimationState();
+}
+
+void AWTFProjectCharacter::SimulateRollbackFrame(const FRollbackInput& Input, const FRollbackInput& PreviousInput, float DeltaTime)
+{
+	bSimulatingRollback = true;
+	CoreState.AimDirection = ToCore(Input.GetAimDirection());
+
+	if (Input.WasPressed(PreviousInput, RollbackButtons::Jump))
+		CharJump();
+	else if (Input.WasReleased(PreviousInput, RollbackButtons::Jump))
+		CharStopJumping();
+
+	if (Input.WasPressed(PreviousInput, RollbackButtons::Pick))
+		Pick();
+
+	if (Input.WasPressed(PreviousInput, RollbackButtons::Throw))
+		Aim();
+	else if (Input.WasReleased(PreviousInput, RollbackButtons::Throw))
+		Throw();
+
+	MoveRight(Input.GetMoveAxis());
+
+	UpdateMovementBlocks(DeltaTime);
+	UpdateCharacter(DeltaTime);
+	if (GetCharacterMovement())
+		GetCharacterMovement()->TickComponent(DeltaTime, LEVELTICK_All, nullptr);
+
+	bSimulatingRollback = false;
+}
+
+void AWTFProjectCharacter::SaveRollbackState(FRollbackCharacterState& State) const
+{
+	const UCharacterMovementComponent* Movement = GetCharacterMovement();
+	State.Location = GetActorLocation();
+	State.Velocity = Movement->Velocity;
+	State.MovementMode = (uint8)Movement->MovementMode;
+	State.Core = CoreState;
+
+	State.bPressedJump = bPressedJump;
+	State.bWasJumping = bWasJumping;
+	State.JumpKeyHoldTime = JumpKeyHoldTime;
+	State.JumpCurrentCount = JumpCurrentCount;
+}
+
+void AWTFProjectCharacter::LoadRollbackState(const FRollbackCharacterState& State)
+{
+	UCharacterMovementComponent* Movement = GetCharacterMovement();
+	SetActorLocation(State.Location, false, nullptr, ETeleportType::TeleportPhysics);
+	SetCharacterDirectionRight(State.Core.bFacingRight);
+	Movement->Velocity = State.Velocity;
+	if (Movement->MovementMode != (EMovementMode)State.MovementMode)
+		Movement->SetMovementMode((EMovementMode)State.MovementMode);
+	if (Movement->IsMovingOnGround())
+		Movement->FindFloor(GetActorLocation(), Movement->CurrentFloor, false);
+
+	CoreState = State.Core;
+	StoneSpriteComponent->SetVisibility(CoreState.Ammo > 0, true);
+
+	bPressedJump = State.bPressedJump;
+	bWasJumping = State.bWasJumping;
+	JumpKeyHoldTime = State.JumpKeyHoldTime;
+	JumpCurrentCount = State.JumpCurrentCount;
 }
 //#pragma optimize("", on)
\ No newline at end of file
@@ -5,10 +5,16 @@
 #include "CoreMinimal.h"
 #include "PaperCharacter.h"
 #include "PaperFlipbookComponent.h"
+#include "Core/CharacterCore.h"
+#include "Net/RollbackTypes.h"
 #include "WTFProjectCharacter.generated.h"
 
 class UTextRenderComponent;
 class AStone;
+class ARollbackManager;
+class AStoneBotController;
+class AProjectileStream;
+struct FGameplayTuning;
 
 /**
  * This class is the default character for WTFProject, and it is responsible for all
@@ -17,6 +23,8 @@ class AStone;
  * The capsule component (inherited from ACharacter) handles collision with the world
  * The CharacterMovementComponent (inherited from ACharacter) handles movement of the collision capsule
  * The Sprite component (inherited from APaperCharacter) handles the visuals
+ * The gameplay rules (ammo, aiming, throwing, movement blocks, animation choice) live in WTFCore::FCharacterRules,
+ * this class feeds them the state of the body and applies the events they return
  */
 
 
@@ -92,6 +100,11 @@ class AWTFProjectCharacter : public APaperCharacter
 {
 	GENERATED_BODY()
 
+	friend class ARollbackManager;
+	friend class AStoneBotController;
+	friend class AProjectileStream;
+	friend class USpriteOverdrawCommandlet;
+
 	/** Side view camera */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Camera, meta=(AllowPrivateAccess="true"))
 	class UCameraComponent* SideViewCameraComponent;
@@ -105,6 +118,7 @@ class AWTFProjectCharacter : public APaperCharacter
 
 	//UTextRenderComponent* TextComponent;
 	virtual void Tick(float DeltaSeconds) override;
+	virtual void PostInitializeComponents() override;
 	virtual void BeginPlay() override;
 
 	FVector StoneSpawnLocation = FVector(0.f, 0.f, 0.f);
@@ -116,39 +130,76 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Animations")
 	TMap<EAnimationState, FAnimations> AnimationStates;
 
-	EAnimationState CurrentAnimationState = EAnimationState::AS_Idle;
+	EAnimationState GetAnimationState() const { return (EAnimationState)CoreState.AnimationState; }
 
 private:
-	bool bIsAiming = false;
-	FVector AimDirection;
-	FVector ThrowDirection;
+	WTFCore::FCharacterState CoreState;
 
-	TArray<FMovementBlock> MovementBlocks;
+	AStone* PickStone = nullptr;
 
-	int Ammo = 5;
+	float StepAccumulator = 0.f;
+	FVector PreviousStepLocation = FVector::ZeroVector;
+	FVector CurrentStepLocation = FVector::ZeroVector;
+	FVector SpriteBaseLocation = FVector::ZeroVector;
+	FVector CameraBoomBaseLocation = FVector::ZeroVector;
+	/** The movement component is ticked by StepGameplay instead of by itself */
+	bool bMovementStepped = false;
+	/** Input of the frame, applied again before every movement step since each step consumes it */
+	float StepMoveAxis = 0.f;
+	bool bStepJumpHeld = false;
 
-	float ThrowTimerCurrent = 0.f;
-	bool bThrowing = false;
+	ARollbackManager* RollbackManager = nullptr;
+	FRollbackInput RollbackInput;
+	bool bSimulatingRollback = false;
 
-	AStone* PickStone = nullptr;
+	/** Latency sample of the last action input, closed when the animation it caused reaches the sprite */
+	uint32 PendingLatencySample = 0;
 
-	bool bIsReversing = false;
+	/** InputAction is the action mapping whose key event the sample is timed from */
+	void BeginLatencySample(const TCHAR* Action, FName InputAction);
+	void CancelLatencySample();
+
+	/** Tuning snapshot the rules and movement were last set up from, replaced by RefreshTuning after a reload */
+	const FGameplayTuning* Tuning = nullptr;
+
+	void RefreshTuning();
 
 public:
-	float ThrowTimer = 0.5f;
+	/**
+	 * Advance gameplay logic (timers, movement blocks, animation choice) in whole steps of 1 / FixedStepRate.
+	 * Locally simulated characters move in the same steps, their sprite and camera are interpolated between the last two.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	bool bFixedStepSimulation = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "1.0", EditCondition = "bFixedStepSimulation"))
+	float FixedStepRate = 60.f;
+
+	/** Upper bound of steps run in one frame, the rest of the backlog is dropped after a hitch */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "1", EditCondition = "bFixedStepSimulation"))
+	int32 MaxStepsPerFrame = 4;
+
+	/** Walks a fixed-step character for Seconds at 30 and at 120 fps and checks both cover the same distance */
+	static bool RunStepCheck(UWorld* World, float Seconds);
 
 protected:
 	bool CanMove() const;
 	void UpdateMovementBlocks(float DeltaTime);
 
+	void StepGameplay(float StepTime);
+	void UpdateInterpolation(float Alpha);
+	void SetMovementStepped(bool bStepped);
+
+	WTFCore::FCharacterContext MakeCoreContext() const;
+	void ApplyCoreEvents(const WTFCore::FCharacterEvents& Events);
+
 	UFUNCTION()
 	void UpdateAnimation();
 	void UpdateFlipbook(bool SameFrame);
-	void UpdateAnimationState();
-	void SetAnimationState(ESimpleAnimationState NewState);
 
 	void MoveRight(float Value);
 	void CharJump();
+	void CharStopJumping();
 
 	void UpdateCharacter(float DeltaSeconds);
 
@@ -158,21 +209,19 @@ protected:
 	virtual void SetupPlayerInputComponent(class UInputComponent* InputComponent) override;
 
 	void Pick();
+	void StopPick();
+	void FinishPick();
 	bool CanPick();
-	void GetStone();
 
 	bool CanThrow();
 	void Throw();
-	void StopThrow();
+	void LaunchStone();
 
 	void Aim();
 	void StopAim();
 	bool IsAiming();
 	bool CanAim();
 
-	void AddMovementBlock(FMovementBlock BlockInfo);
-	void RemoveSpecificMovementBlock(EMovementBlockReason Block);
-
 	void AttachStone();
 	void DetachStone();
 
@@ -180,9 +229,16 @@ protected:
 
 	void SetCharacterDirectionRight(bool IsRight);
 
+	/** In a rollback session input handlers only record into RollbackInput, the manager replays it */
+	bool CaptureRollbackInput() const { return RollbackManager && !bSimulatingRollback; }
+
 public:
+	void EnableRollback(ARollbackManager* Manager);
+	void SimulateRollbackFrame(const FRollbackInput& Input, const FRollbackInput& PreviousInput, float DeltaTime);
+	void SaveRollbackState(FRollbackCharacterState& State) const;
+	void LoadRollbackState(const FRollbackCharacterState& State);
 
-	AWTFProjectCharacter();
+	AWTFProjectCharacter(const FObjectInitializer& ObjectInitializer);
 
 	FORCEINLINE class UCameraComponent* GetSideViewCameraComponent() const { return SideViewCameraComponent; }
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Steps headless characters through the gameplay rules with random input and reports steps per second.
+// Needs no engine, build it next to the module sources:
+//
+//   c++ -std=c++14 -O2 -I../../Source/WTFProject CoreBenchmark.cpp ../../Source/WTFProject/Core/CharacterCore.cpp -o CoreBenchmark
+//   ./CoreBenchmark [Characters=1024] [Steps=10000]
+
+#include "Core/CharacterCore.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace WTFCore;
+
+namespace
+{
+	struct FRandomStream
+	{
+		uint32_t Seed;
+
+		uint32_t Next()
+		{
+			Seed ^= Seed << 13;
+			Seed ^= Seed >> 17;
+			Seed ^= Seed << 5;
+			return Seed;
+		}
+
+		float NextFloat() { return (Next() & 0xFFFFFF) / float(0xFFFFFF); }
+	};
+
+	/** Holds buttons for a few steps like a player would, so presses and releases actually happen */
+	void RandomizeInput(FRandomStream& Random, FHeadlessInput& Input)
+	{
+		Input.MoveAxis = Random.NextFloat() * 2.f - 1.f;
+		Input.Aim = FVec2(Random.NextFloat() * 2.f - 1.f, Random.NextFloat() * 2.f - 1.f);
+		const uint32_t Buttons = Random.Next();
+		Input.bJump = (Buttons & 0x7) == 0;
+		Input.bAim = (Buttons & 0x18) != 0;
+		Input.bPick = (Buttons & 0xE0) == 0;
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	const int NumCharacters = Argc > 1 ? std::atoi(Argv[1]) : 1024;
+	const int NumSteps = Argc > 2 ? std::atoi(Argv[2]) : 10000;
+	const int InputPeriod = 8;
+	const float StepTime = 1.f / 60.f;
+
+	FCharacterTuning Tuning;
+	std::vector<FHeadlessCharacter> Characters(NumCharacters);
+	std::vector<FHeadlessInput> Inputs(NumCharacters);
+	std::vector<FRandomStream> Randoms(NumCharacters);
+	for (int i = 0; i < NumCharacters; i++)
+	{
+		FCharacterRules::Reset(Characters[i].State, Tuning);
+		Randoms[i].Seed = 2463534242u + i * 7919u;
+	}
+
+	const auto Start = std::chrono::steady_clock::now();
+	for (int Step = 0; Step < NumSteps; Step++)
+	{
+		for (int i = 0; i < NumCharacters; i++)
+		{
+			if ((Step + i) % InputPeriod == 0)
+				RandomizeInput(Randoms[i], Inputs[i]);
+			Characters[i].Step(Tuning, Inputs[i], StepTime);
+		}
+	}
+	const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+	long long Thrown = 0;
+	for (const FHeadlessCharacter& Character : Characters)
+		Thrown += Character.StonesThrown;
+
+	const double TotalSteps = double(NumCharacters) * NumSteps;
+	std::printf("%d characters x %d steps in %.3fs: %.2f M steps/s, %.1f ns/step, %lld stones thrown\n",
+		NumCharacters, NumSteps, Seconds, TotalSteps / Seconds / 1e6, Seconds * 1e9 / TotalSteps, Thrown);
+	return 0;
+}
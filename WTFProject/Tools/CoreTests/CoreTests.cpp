@@ -0,0 +1,278 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Rule-level tests of the character core plus a fuzzer that checks state invariants under random input.
+// Needs no engine, build it next to the module sources:
+//
+//   c++ -std=c++14 -O2 -Wall -Wextra -I../../Source/WTFProject CoreTests.cpp ../../Source/WTFProject/Core/CharacterCore.cpp -o CoreTests
+//   ./CoreTests [FuzzSteps=200000]
+//
+// Exits with 1 if any check failed.
+
+#include "Core/CharacterCore.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace WTFCore;
+
+namespace
+{
+	int NumChecks = 0;
+	int NumFailed = 0;
+
+	#define CHECK(Condition) Check((Condition), #Condition, __FILE__, __LINE__)
+
+	void Check(bool bCondition, const char* Text, const char* File, int Line)
+	{
+		NumChecks++;
+		if (bCondition)
+			return;
+
+		NumFailed++;
+		std::printf("%s(%d): check failed: %s\n", File, Line, Text);
+	}
+
+	FVec2 AimAtDegrees(float Degrees, bool bRight = true)
+	{
+		const float Radians = Degrees / 57.2957795f;
+		return FVec2((bRight ? 1.f : -1.f) * std::cos(Radians), std::sin(Radians));
+	}
+
+	EAnimationState AimAnimation(const FCharacterTuning& Tuning, float Degrees, bool bRight = true)
+	{
+		FCharacterState State;
+		FCharacterRules::Reset(State, Tuning);
+		FCharacterContext Context;
+		Context.Forward = FVec2(bRight ? 1.f : -1.f, 0.f);
+		State.AimDirection = AimAtDegrees(Degrees, bRight);
+
+		FCharacterEvents Events;
+		FCharacterRules::Aim(State, Context);
+		FCharacterRules::Update(State, Context, Tuning, 1.f / 60.f, Events);
+		return State.AnimationState;
+	}
+
+	void TestAimSectors()
+	{
+		const FCharacterTuning Tuning;
+		CHECK(AimAnimation(Tuning, 0.f) == EAnimationState::AimingFront);
+		CHECK(AimAnimation(Tuning, 20.f) == EAnimationState::AimingFront);
+		CHECK(AimAnimation(Tuning, -20.f) == EAnimationState::AimingFront);
+		CHECK(AimAnimation(Tuning, 40.f) == EAnimationState::AimingUp);
+		CHECK(AimAnimation(Tuning, -40.f) == EAnimationState::AimingDown);
+		CHECK(AimAnimation(Tuning, 80.f) == EAnimationState::AimingUp);
+
+		// Sectors are measured from the facing direction
+		CHECK(AimAnimation(Tuning, 40.f, false) == EAnimationState::AimingUp);
+		CHECK(AimAnimation(Tuning, -20.f, false) == EAnimationState::AimingFront);
+
+		FCharacterTuning Wide;
+		Wide.AimSectorDegrees = 45.f;
+		CHECK(AimAnimation(Wide, 40.f) == EAnimationState::AimingFront);
+		CHECK(AimAnimation(Wide, 50.f) == EAnimationState::AimingUp);
+
+		// Walking while aiming uses the walking variants
+		FCharacterState State;
+		FCharacterRules::Reset(State, Tuning);
+		FCharacterContext Context;
+		Context.Velocity = FVec2(600.f, 0.f);
+		State.AimDirection = AimAtDegrees(-40.f);
+		FCharacterEvents Events;
+		FCharacterRules::Aim(State, Context);
+		FCharacterRules::Update(State, Context, Tuning, 1.f / 60.f, Events);
+		CHECK(State.AnimationState == EAnimationState::WalkAimingDown);
+		CHECK(Events.Has(CharacterEvents::SameFrame));
+	}
+
+	void TestPickBlock()
+	{
+		FCharacterTuning Tuning;
+		Tuning.InitialAmmo = 0;
+		FCharacterState State;
+		FCharacterRules::Reset(State, Tuning);
+		const FCharacterContext Context;
+
+		CHECK(FCharacterRules::CanPick(State, Context));
+		FCharacterEvents Events;
+		FCharacterRules::PickStone(State, Context, Tuning, Events);
+		CHECK(State.Ammo == 1);
+		CHECK(Events.Has(CharacterEvents::AttachStone));
+		CHECK(Events.Has(CharacterEvents::StopMovement));
+		CHECK(Events.BlocksAdded == 1 << (int)EMovementBlockReason::Pick);
+		CHECK(State.AnimationState == EAnimationState::Pick);
+		CHECK(!FCharacterRules::CanMove(State));
+		CHECK(!FCharacterRules::CanJump(State, Context));
+
+		// Blocked for PickBlockTime
+		Events.Reset();
+		FCharacterRules::UpdateMovementBlocks(State, Tuning.PickBlockTime - 0.05f, Events);
+		CHECK(!FCharacterRules::CanMove(State));
+		CHECK(Events.BlocksRemoved == 0);
+		FCharacterRules::UpdateMovementBlocks(State, 0.1f, Events);
+		CHECK(FCharacterRules::CanMove(State));
+		CHECK(Events.BlocksRemoved == 1 << (int)EMovementBlockReason::Pick);
+
+		// A second pick while blocked replaces the block instead of stacking it
+		Events.Reset();
+		FCharacterRules::PickStone(State, Context, Tuning, Events);
+		FCharacterRules::PickStone(State, Context, Tuning, Events);
+		CHECK(State.Ammo == 3);
+		CHECK(!Events.Has(CharacterEvents::AttachStone));
+		CHECK(State.NumMovementBlocks == 1);
+
+		FCharacterContext Falling;
+		Falling.bFalling = true;
+		CHECK(!FCharacterRules::CanPick(State, Falling));
+	}
+
+	void TestThrowRelease()
+	{
+		const FCharacterTuning Tuning;
+		FCharacterState State;
+		FCharacterRules::Reset(State, Tuning);
+		FCharacterContext Context;
+		FCharacterEvents Events;
+
+		// Releasing without aiming first does nothing
+		CHECK(!FCharacterRules::Throw(State, Context, Tuning, FVec2(1.f, 0.f), Events));
+		CHECK(Events.Flags == 0);
+
+		FCharacterRules::Aim(State, Context);
+		CHECK(State.bIsAiming);
+		const FVec2 Direction = AimAtDegrees(10.f);
+		CHECK(FCharacterRules::Throw(State, Context, Tuning, Direction, Events));
+		CHECK(State.bThrowing);
+		CHECK(!State.bIsAiming);
+		CHECK(State.ThrowDirection.X == Direction.X && State.ThrowDirection.Z == Direction.Z);
+		CHECK(State.AnimationState == EAnimationState::ThrowFront);
+		CHECK(!FCharacterRules::CanMove(State));
+		CHECK(!FCharacterRules::CanAim(State, Context));
+
+		// The stone leaves the hand ThrowTimer after the release, not before
+		Events.Reset();
+		FCharacterRules::Update(State, Context, Tuning, Tuning.ThrowTimer - 0.05f, Events);
+		CHECK(!Events.Has(CharacterEvents::LaunchStone));
+		CHECK(State.Ammo == Tuning.InitialAmmo);
+		FCharacterRules::Update(State, Context, Tuning, 0.1f, Events);
+		CHECK(Events.Has(CharacterEvents::LaunchStone));
+		CHECK(!Events.Has(CharacterEvents::DetachStone));
+		CHECK(State.Ammo == Tuning.InitialAmmo - 1);
+		CHECK(!State.bThrowing);
+
+		// The last stone detaches from the hand
+		State.Ammo = 1;
+		Events.Reset();
+		FCharacterRules::Aim(State, Context);
+		FCharacterRules::Throw(State, Context, Tuning, Direction, Events);
+		FCharacterRules::Update(State, Context, Tuning, Tuning.ThrowTimer, Events);
+		CHECK(Events.Has(CharacterEvents::LaunchStone));
+		CHECK(Events.Has(CharacterEvents::DetachStone));
+		CHECK(State.Ammo == 0);
+		CHECK(!FCharacterRules::CanAim(State, Context));
+
+		// A host that cannot launch keeps the ammo
+		State.Ammo = 2;
+		Events.Reset();
+		FCharacterRules::Aim(State, Context);
+		FCharacterRules::Throw(State, Context, Tuning, Direction, Events);
+		Context.bCanLaunchStone = false;
+		FCharacterRules::Update(State, Context, Tuning, Tuning.ThrowTimer, Events);
+		CHECK(!Events.Has(CharacterEvents::LaunchStone));
+		CHECK(State.Ammo == 2);
+		CHECK(!State.bThrowing);
+	}
+
+	void TestHeadlessThrowUsesCurrentAim()
+	{
+		const FCharacterTuning Tuning;
+		FHeadlessCharacter Character;
+		FCharacterRules::Reset(Character.State, Tuning);
+
+		FHeadlessInput Input;
+		Input.bAim = true;
+		Input.Aim = AimAtDegrees(0.f);
+		Character.Step(Tuning, Input, 1.f / 60.f);
+
+		// Released in the same step the aim moved up
+		Input.bAim = false;
+		Input.Aim = AimAtDegrees(60.f);
+		Character.Step(Tuning, Input, 1.f / 60.f);
+		CHECK(Character.State.bThrowing);
+		CHECK(Character.State.ThrowDirection.Z == Input.Aim.Z);
+		CHECK(Character.State.AnimationState == EAnimationState::ThrowUp);
+	}
+
+	struct FRandomStream
+	{
+		uint32_t Seed;
+
+		uint32_t Next()
+		{
+			Seed ^= Seed << 13;
+			Seed ^= Seed >> 17;
+			Seed ^= Seed << 5;
+			return Seed;
+		}
+
+		float NextFloat() { return (Next() & 0xFFFFFF) / float(0xFFFFFF); }
+	};
+
+	/** Random held buttons and steps, checking what must hold for any input */
+	void FuzzInvariants(int Steps)
+	{
+		FCharacterTuning Tuning;
+		FRandomStream Random = { 0x5EED1234u };
+		FHeadlessCharacter Character;
+		FCharacterRules::Reset(Character.State, Tuning);
+		FHeadlessInput Input;
+
+		const int FailedBefore = NumFailed;
+		for (int Step = 0; Step < Steps && NumFailed - FailedBefore < 10; Step++)
+		{
+			if (Random.Next() % 8 == 0)
+			{
+				const uint32_t Buttons = Random.Next();
+				Input.bJump = (Buttons & 1) != 0;
+				Input.bAim = (Buttons & 2) != 0;
+				Input.bPick = (Buttons & 4) != 0 && (Buttons & 24) == 0;
+				Input.MoveAxis = Random.NextFloat() * 2.f - 1.f;
+			}
+			Input.Aim = FVec2(Random.NextFloat() * 2.f - 1.f, Random.NextFloat() * 2.f - 1.f);
+
+			const int32_t AmmoBefore = Character.State.Ammo;
+			const int32_t ThrownBefore = Character.StonesThrown;
+			Character.Step(Tuning, Input, (1 + Random.Next() % 4) / 60.f);
+			const FCharacterState& State = Character.State;
+
+			CHECK(State.Ammo >= 0);
+			CHECK(State.NumMovementBlocks >= 0 && State.NumMovementBlocks <= FCharacterState::MaxMovementBlocks);
+			for (int32_t i = 0; i < State.NumMovementBlocks; i++)
+			{
+				for (int32_t j = i + 1; j < State.NumMovementBlocks; j++)
+					CHECK(State.MovementBlocks[i].Reason != State.MovementBlocks[j].Reason);
+			}
+			CHECK(!State.bThrowing || State.ThrowTimerCurrent <= Tuning.ThrowTimer);
+			CHECK(!(State.bIsAiming && State.bThrowing));
+			CHECK(Character.StonesThrown - ThrownBefore <= 1);
+
+			// Ammo only goes down by the stone that was thrown this step
+			if (State.Ammo < AmmoBefore)
+				CHECK(AmmoBefore - State.Ammo == Character.StonesThrown - ThrownBefore);
+		}
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	const int FuzzSteps = Argc > 1 ? std::atoi(Argv[1]) : 200000;
+
+	TestAimSectors();
+	TestPickBlock();
+	TestThrowRelease();
+	TestHeadlessThrowUsesCurrentAim();
+	FuzzInvariants(FuzzSteps);
+
+	std::printf("%d checks, %d failed\n", NumChecks, NumFailed);
+	return NumFailed == 0 ? 0 : 1;
+}